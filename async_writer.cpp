@@ -0,0 +1,207 @@
+#include "async_writer.h"
+#include "metrics.h"
+#include <iostream>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+AsyncWriter::AsyncWriter(const AsyncWriterConfig& _config)
+    : config(_config), queue(_config.queueCapacity), results(nullptr) {
+    if (config.writeCrops && !archive.open(config.archive)) {
+        config.writeCrops = false;
+    }
+    if (!config.resultsPath.empty()) {
+        results = fopen(config.resultsPath.c_str(), "ab");
+        if (results == nullptr) {
+            std::cerr << "Could not open results file " << config.resultsPath << std::endl;
+        } else {
+            setvbuf(results, nullptr, _IOFBF, 1 << 20);
+            writeResults = true;
+        }
+    }
+    if (!config.detectionLogPath.empty()) {
+        writeDetections = detectionLog.open(config.detectionLogPath);
+    }
+    lastSync = chrono::steady_clock::now();
+    worker = thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    stop();
+}
+
+void AsyncWriter::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    wakeCondition.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    //un enqueue care a vazut running == true poate pune elementul in coada dupa ce worker-ul a
+    //iesit; dupa ce se termina toate, ce a ramas e scris aici, cat fisierele sunt inca deschise
+    while (submitting.load() > 0) {
+        this_thread::yield();
+    }
+    vector<WriteItem> late;
+    WriteItem item;
+    while (queue.tryPop(item)) {
+        late.push_back(move(item));
+    }
+    if (!late.empty()) {
+        writeBatch(late);
+        if (dirty && config.fsync != FsyncPolicy::NEVER) {
+            sync();
+        }
+    }
+    archive.close();
+    detectionLog.close();
+    if (results != nullptr) {
+        fclose(results);
+        results = nullptr;
+    }
+}
+
+bool AsyncWriter::enqueue(WriteItem&& item) {
+    //submitting inainte de running (ambele seq_cst): fie stop() vede enqueue-ul si il asteapta,
+    //fie enqueue-ul vede running == false si elementul e numarat ca pierdut
+    submitting++;
+    bool pushed = running && queue.tryPush(move(item));
+    submitting--;
+    if (!pushed) {
+        dropped++;
+        Metrics::increment(COUNTER_WRITER_DROPPED);
+        return false;
+    }
+    //maximul e aproximativ: doi producatori pot scrie valori vechi in acelasi timp
+    size_t depth = queue.size();
+    if (depth > maxDepth.load(memory_order_relaxed)) {
+        maxDepth.store(depth, memory_order_relaxed);
+    }
+    if (sleeping.load()) {
+        wakeCondition.notify_one();
+    }
+    return true;
+}
+
+bool AsyncWriter::submitCrop(uint64_t frameId, int64_t timestampNs, const MyRect& box, const Mat& crop) {
+    if (!config.writeCrops) {
+        return false;
+    }
+    WriteItem item;
+    item.kind = WriteItem::CROP;
+    item.frameId = frameId;
+    item.timestampNs = timestampNs;
+    item.box = box;
+    item.crop = crop.clone();
+    return enqueue(move(item));
+}
+
+bool AsyncWriter::submitLine(string line) {
+    if (!writeResults) {
+        return false;
+    }
+    WriteItem item;
+    item.kind = WriteItem::LINE;
+    item.line = move(line);
+    return enqueue(move(item));
+}
+
+bool AsyncWriter::submitDetections(vector<DetectionRecord> detections) {
+    if (!writeDetections) {
+        return false;
+    }
+    WriteItem item;
+    item.kind = WriteItem::DETECTIONS;
+    item.detections = move(detections);
+    return enqueue(move(item));
+}
+
+void AsyncWriter::run() {
+    Tracer::setThreadName("async writer");
+    vector<WriteItem> batch;
+    batch.reserve(config.maxBatch);
+    while (true) {
+        WriteItem item;
+        while (batch.size() < config.maxBatch && queue.tryPop(item)) {
+            batch.push_back(move(item));
+        }
+        if (!batch.empty()) {
+            writeBatch(batch);
+            batch.clear();
+            continue;
+        }
+
+        if (config.fsync == FsyncPolicy::INTERVAL && dirty &&
+            chrono::steady_clock::now() - lastSync >= chrono::milliseconds(config.fsyncIntervalMs)) {
+            sync();
+        }
+        if (!running) {
+            //stop() a fost apelat dupa ultimul submit: coada e deja golita
+            if (queue.size() == 0) {
+                break;
+            }
+            continue;
+        }
+        //o notificare pierduta intre verificare si wait costa cel mult idleWaitMs
+        sleeping = true;
+        if (queue.size() == 0) {
+            unique_lock<mutex> lock(wakeMutex);
+            wakeCondition.wait_for(lock, chrono::milliseconds(config.idleWaitMs));
+        }
+        sleeping = false;
+    }
+    if (dirty && config.fsync != FsyncPolicy::NEVER) {
+        sync();
+    }
+}
+
+//decupajele sunt pregatite (compactare / JPEG) aici, pe thread-ul writer-ului, apoi scrise
+//impreuna: payload-urile, un flush, intrarile de index
+void AsyncWriter::writeBatch(vector<WriteItem>& batch) {
+    TraceSpan span("write batch");
+    vector<CropRecord> records;
+    for (auto& item : batch) {
+        if (item.kind == WriteItem::CROP) {
+            records.emplace_back();
+            if (!archive.prepare(item.frameId, item.timestampNs, item.box, item.crop, records.back())) {
+                records.pop_back();
+            }
+        } else if (item.kind == WriteItem::DETECTIONS) {
+            //randurile se strang in memorie; doar un bloc plin ajunge pe disc
+            for (const auto& detection : item.detections) {
+                detectionLog.append(detection);
+            }
+        } else if (results != nullptr) {
+            fwrite(item.line.data(), 1, item.line.size(), results);
+            fputc('\n', results);
+        }
+    }
+    if (!records.empty()) {
+        archive.write(records);
+    }
+    if (results != nullptr) {
+        fflush(results);
+    }
+    written += (long long)batch.size();
+    batches++;
+    dirty = true;
+    if (config.fsync == FsyncPolicy::PER_BATCH) {
+        sync();
+    }
+}
+
+void AsyncWriter::sync() {
+    archive.sync();
+    //randurile din memorie devin un bloc, ca un crash sa piarda cel mult un interval de fsync
+    detectionLog.sync();
+    if (results != nullptr) {
+        fflush(results);
+#ifndef _WIN32
+        ::fsync(fileno(results));
+#endif
+    }
+    fsyncs++;
+    dirty = false;
+    lastSync = chrono::steady_clock::now();
+}
@@ -0,0 +1,103 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "bounded_queue.h"
+#include "crop_archive.h"
+#include "detection_log.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+using namespace std;
+using namespace cv;
+
+enum class FsyncPolicy {
+    NEVER,     //doar flush catre kernel dupa fiecare lot; jurnalul de detectii scrie doar blocuri pline
+    PER_BATCH, //fsync dupa fiecare lot scris
+    INTERVAL   //fsync cel mult o data la fsyncIntervalMs, daca s-a scris ceva
+};
+
+struct AsyncWriterConfig {
+    size_t queueCapacity = 1024; //rotunjita la o putere a lui 2
+    size_t maxBatch = 64; //elemente scrise intre doua flush-uri
+    FsyncPolicy fsync = FsyncPolicy::INTERVAL;
+    int fsyncIntervalMs = 1000;
+    int idleWaitMs = 5; //cat asteapta writer-ul cand coada e goala
+    bool writeCrops = true;
+    ArchiveConfig archive; //codarea JPEG, daca e ceruta, se face pe thread-ul writer-ului
+    string resultsPath; //linii JSON; gol = fara fisier de rezultate
+    string detectionLogPath; //jurnalul binar pe coloane; gol = dezactivat
+};
+
+//ce se scrie: un decupaj pentru arhiva, o linie de rezultate sau detectiile unui cadru
+struct WriteItem {
+    enum Kind : uint8_t { CROP, LINE, DETECTIONS } kind = LINE;
+    uint64_t frameId = 0;
+    int64_t timestampNs = 0;
+    MyRect box;
+    Mat crop; //copie proprie, cadrul sursa poate fi eliberat imediat
+    string line;
+    vector<DetectionRecord> detections;
+};
+
+//toate scrierile pe disc pe un singur thread: detectia doar pune elemente intr-o coada fara
+//lock-uri si nu asteapta niciodata discul; cand coada e plina elementul e aruncat si numarat.
+//Writer-ul scoate loturi de pana la maxBatch elemente, le scrie prin buffere mari (un flush pe
+//lot) si aplica politica de fsync.
+class AsyncWriter {
+public:
+    explicit AsyncWriter(const AsyncWriterConfig& config);
+    //scrie tot ce e in coada, apoi opreste thread-ul
+    ~AsyncWriter();
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    //false = coada plina, elementul a fost aruncat
+    bool submitCrop(uint64_t frameId, int64_t timestampNs, const MyRect& box, const Mat& crop);
+    bool submitLine(string line);
+    bool submitDetections(vector<DetectionRecord> detections);
+    void stop();
+
+    size_t queueDepth() const { return queue.size(); }
+    size_t maxQueueDepth() const { return maxDepth.load(); }
+    long long droppedItems() const { return dropped.load(); }
+    long long writtenItems() const { return written.load(); }
+    long long batchCount() const { return batches.load(); }
+    long long fsyncCount() const { return fsyncs.load(); }
+
+private:
+    bool enqueue(WriteItem&& item);
+    void run();
+    void writeBatch(vector<WriteItem>& batch);
+    void sync();
+
+    AsyncWriterConfig config;
+    BoundedQueue<WriteItem> queue;
+    CropArchiveWriter archive;
+    FILE* results;
+    DetectionLogWriter detectionLog;
+    bool writeDetections = false;
+    bool writeResults = false; //fixat la constructie; results devine nullptr la stop()
+
+    //doar pentru a trezi writer-ul; producatorii nu iau mutexul
+    mutex wakeMutex;
+    condition_variable wakeCondition;
+    atomic<bool> sleeping{false};
+    atomic<bool> running{true};
+    atomic<int> submitting{0}; //enqueue-uri in curs; stop() le asteapta inainte de ultima golire
+    thread worker;
+
+    atomic<size_t> maxDepth{0};
+    atomic<long long> dropped{0};
+    atomic<long long> written{0};
+    atomic<long long> batches{0};
+    atomic<long long> fsyncs{0};
+    bool dirty = false;
+    chrono::steady_clock::time_point lastSync;
+};
+
+#endif
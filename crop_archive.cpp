@@ -0,0 +1,335 @@
+#include "crop_archive.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static string segmentPath(const string& directory, uint32_t number, const char* extension) {
+    char name[32];
+    snprintf(name, sizeof(name), "segment-%06u.%s", number, extension);
+    return (fs::path(directory) / name).string();
+}
+
+//numarul segmentului din numele fisierului, -1 daca nu e un segment
+static long long segmentNumber(const fs::path& path, const char* extension) {
+    string name = path.filename().string();
+    string suffix = string(".") + extension;
+    if (name.size() != 8 + 6 + suffix.size() || name.compare(0, 8, "segment-") != 0 ||
+        name.compare(14, suffix.size(), suffix) != 0) {
+        return -1;
+    }
+    return stoll(name.substr(8, 6));
+}
+
+static vector<uint32_t> listSegments(const string& directory) {
+    vector<uint32_t> numbers;
+    error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        long long number = segmentNumber(entry.path(), "idx");
+        if (number >= 0) {
+            numbers.push_back((uint32_t)number);
+        }
+    }
+    sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+CropArchiveWriter::~CropArchiveWriter() {
+    close();
+}
+
+bool CropArchiveWriter::open(const ArchiveConfig& _config) {
+    close();
+    config = _config;
+    error_code error;
+    fs::create_directories(config.directory, error);
+    vector<uint32_t> existing = listSegments(config.directory);
+    return openSegment(existing.empty() ? 0 : existing.back() + 1);
+}
+
+bool CropArchiveWriter::openSegment(uint32_t number) {
+    if (data != nullptr) {
+        fclose(data);
+        fclose(index);
+        data = index = nullptr;
+    }
+    string dataPath = segmentPath(config.directory, number, "dat");
+    string indexPath = segmentPath(config.directory, number, "idx");
+    data = fopen(dataPath.c_str(), "wb");
+    index = fopen(indexPath.c_str(), "wb");
+    if (data != nullptr && index != nullptr) {
+        //scrierile se strang in buffere mari si ajung la kernel o data pe lot
+        setvbuf(data, nullptr, _IOFBF, 1 << 20);
+        setvbuf(index, nullptr, _IOFBF, 64 << 10);
+    }
+    if (data == nullptr || index == nullptr) {
+        std::cerr << "Could not create archive segment " << dataPath << std::endl;
+        close();
+        return false;
+    }
+
+    CropFileHeader header = {};
+    header.version = CROP_ARCHIVE_VERSION;
+    header.segment = number;
+    header.magic = CROP_DATA_MAGIC;
+    fwrite(&header, sizeof(header), 1, data);
+    header.magic = CROP_INDEX_MAGIC;
+    fwrite(&header, sizeof(header), 1, index);
+    segment = number;
+    offset = CROP_FILE_HEADER_BYTES;
+    return true;
+}
+
+void CropArchiveWriter::close() {
+    if (data != nullptr) {
+        fclose(data);
+    }
+    if (index != nullptr) {
+        fclose(index);
+    }
+    data = index = nullptr;
+}
+
+bool CropArchiveWriter::prepare(uint64_t frameId, int64_t timestampNs, const MyRect& box, const Mat& crop,
+                                CropRecord& record) const {
+    if (crop.empty() || crop.depth() != CV_8U) {
+        return false;
+    }
+    CropIndexEntry& entry = record.entry;
+    entry = {};
+    entry.frameId = frameId;
+    entry.timestampNs = timestampNs;
+    entry.x = box.x;
+    entry.y = box.y;
+    entry.width = box.width;
+    entry.height = box.height;
+    entry.cropWidth = (uint16_t)crop.cols;
+    entry.cropHeight = (uint16_t)crop.rows;
+    entry.channels = (uint8_t)crop.channels();
+    entry.encoding = (uint8_t)config.encoding;
+
+    //RAW: randurile decupajului (un ROI cu stride) compactate intr-un singur buffer
+    if (config.encoding == CropEncoding::JPEG) {
+        imencode(".jpg", crop, record.payload, {IMWRITE_JPEG_QUALITY, config.jpegQuality});
+    } else {
+        size_t rowBytes = (size_t)crop.cols * crop.channels();
+        record.payload.resize(rowBytes * crop.rows);
+        for (int i = 0; i < crop.rows; i++) {
+            memcpy(record.payload.data() + i * rowBytes, crop.ptr<uchar>(i), rowBytes);
+        }
+    }
+    entry.length = (uint32_t)record.payload.size();
+    return true;
+}
+
+bool CropArchiveWriter::append(uint64_t frameId, int64_t timestampNs, const MyRect& box, const Mat& crop) {
+    vector<CropRecord> records(1);
+    return prepare(frameId, timestampNs, box, crop, records[0]) && write(records);
+}
+
+bool CropArchiveWriter::write(vector<CropRecord>& records) {
+    if (data == nullptr) {
+        return false;
+    }
+    size_t first = 0;
+    while (first < records.size()) {
+        //cate intrari incap in segmentul curent (macar una, chiar daca e mai mare decat segmentul)
+        size_t last = first;
+        uint64_t end = offset;
+        while (last < records.size() &&
+               (end == CROP_FILE_HEADER_BYTES || end + records[last].entry.length <= config.segmentBytes)) {
+            records[last].entry.offset = end;
+            end += records[last].entry.length;
+            last++;
+        }
+        if (last == first) {
+            if (!openSegment(segment + 1)) {
+                return false;
+            }
+            continue;
+        }
+
+        for (size_t r = first; r < last; r++) {
+            const vector<uchar>& payload = records[r].payload;
+            if (fwrite(payload.data(), 1, payload.size(), data) != payload.size()) {
+                return abandonSegment();
+            }
+        }
+        //datele inaintea intrarilor din index, ca o intrare completa sa nu trimita la date lipsa
+        fflush(data);
+        for (size_t r = first; r < last; r++) {
+            if (fwrite(&records[r].entry, sizeof(CropIndexEntry), 1, index) != 1) {
+                return abandonSegment();
+            }
+            written += records[r].entry.length + sizeof(CropIndexEntry);
+        }
+        fflush(index);
+        offset = end;
+        first = last;
+    }
+    return true;
+}
+
+//dupa o scriere partiala, pozitia reala din .dat nu mai corespunde cu offset; intrarile urmatoare
+//ar trimite la date gresite, deci segmentul ramane cum e (cititorul ignora coada incompleta) si
+//scrierea continua intr-unul nou. Daca nici acela nu se poate crea, writer-ul ramane inchis
+bool CropArchiveWriter::abandonSegment() {
+    std::cerr << "Archive write failed, closing segment " << segment << std::endl;
+    openSegment(segment + 1);
+    return false;
+}
+
+void CropArchiveWriter::flush() {
+    if (data != nullptr) {
+        fflush(data);
+        fflush(index);
+    }
+}
+
+void CropArchiveWriter::sync() {
+    if (data == nullptr) {
+        return;
+    }
+    fflush(data);
+#ifndef _WIN32
+    ::fsync(fileno(data));
+#endif
+    fflush(index);
+#ifndef _WIN32
+    ::fsync(fileno(index));
+#endif
+}
+
+CropArchiveReader::~CropArchiveReader() {
+    close();
+}
+
+bool CropArchiveReader::mapFile(const string& path, MappedFile& file) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < (off_t)CROP_FILE_HEADER_BYTES) {
+        ::close(fd);
+        return false;
+    }
+    void* memory = ::mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); //maparea ramane valida dupa inchiderea descriptorului
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    file.data = static_cast<const uchar*>(memory);
+    file.bytes = (size_t)info.st_size;
+#else
+    std::ifstream in(path, std::ios::binary);
+    file.fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (file.fallback.size() < CROP_FILE_HEADER_BYTES) {
+        return false;
+    }
+    file.data = file.fallback.data();
+    file.bytes = file.fallback.size();
+#endif
+    return true;
+}
+
+void CropArchiveReader::unmapFile(MappedFile& file) {
+#ifndef _WIN32
+    if (file.data != nullptr) {
+        ::munmap(const_cast<uchar*>(file.data), file.bytes);
+    }
+#endif
+    file.data = nullptr;
+    file.bytes = 0;
+    file.fallback.clear();
+}
+
+bool CropArchiveReader::open(const string& directory) {
+    close();
+    for (uint32_t number : listSegments(directory)) {
+        segments.emplace_back();
+        indexes.emplace_back();
+        if (!mapFile(segmentPath(directory, number, "dat"), segments.back()) ||
+            !mapFile(segmentPath(directory, number, "idx"), indexes.back())) {
+            std::cerr << "Skipping unreadable archive segment " << number << std::endl;
+            unmapFile(segments.back());
+            unmapFile(indexes.back());
+            segments.pop_back();
+            indexes.pop_back();
+            continue;
+        }
+        const CropFileHeader* dataHeader = reinterpret_cast<const CropFileHeader*>(segments.back().data);
+        const CropFileHeader* indexHeader = reinterpret_cast<const CropFileHeader*>(indexes.back().data);
+        if (dataHeader->magic != CROP_DATA_MAGIC || indexHeader->magic != CROP_INDEX_MAGIC ||
+            dataHeader->version != CROP_ARCHIVE_VERSION || indexHeader->version != CROP_ARCHIVE_VERSION) {
+            std::cerr << "Archive segment " << number << " has an unknown format" << std::endl;
+            unmapFile(segments.back());
+            unmapFile(indexes.back());
+            segments.pop_back();
+            indexes.pop_back();
+            continue;
+        }
+
+        //o intrare incompleta la coada (scriere intrerupta) e ignorata
+        int s = (int)segments.size() - 1;
+        size_t count = (indexes.back().bytes - CROP_FILE_HEADER_BYTES) / sizeof(CropIndexEntry);
+        const CropIndexEntry* entries =
+            reinterpret_cast<const CropIndexEntry*>(indexes.back().data + CROP_FILE_HEADER_BYTES);
+        for (size_t e = 0; e < count; e++) {
+            //fara suma offset + length, care la o intrare corupta poate depasi uint64 si trece testul
+            if (entries[e].offset >= CROP_FILE_HEADER_BYTES && entries[e].length <= segments.back().bytes &&
+                entries[e].offset <= segments.back().bytes - entries[e].length) {
+                locations.push_back(Location{&entries[e], s});
+            }
+        }
+    }
+    //stable: decupajele aceluiasi cadru raman in ordinea scrierii
+    stable_sort(locations.begin(), locations.end(), [](const Location& a, const Location& b) {
+        return a.entry->frameId < b.entry->frameId;
+    });
+    return !segments.empty();
+}
+
+void CropArchiveReader::close() {
+    for (auto& file : segments) {
+        unmapFile(file);
+    }
+    for (auto& file : indexes) {
+        unmapFile(file);
+    }
+    segments.clear();
+    indexes.clear();
+    locations.clear();
+}
+
+vector<CropArchiveReader::Location> CropArchiveReader::find(uint64_t frameId) const {
+    auto first = lower_bound(locations.begin(), locations.end(), frameId,
+                             [](const Location& a, uint64_t id) { return a.entry->frameId < id; });
+    vector<Location> result;
+    for (auto it = first; it != locations.end() && it->entry->frameId == frameId; ++it) {
+        result.push_back(*it);
+    }
+    return result;
+}
+
+Mat CropArchiveReader::crop(const Location& location) const {
+    const CropIndexEntry& entry = *location.entry;
+    const uchar* payload = segments[location.segment].data + entry.offset;
+    if (entry.encoding == (uint8_t)CropEncoding::JPEG) {
+        return imdecode(Mat(1, (int)entry.length, CV_8UC1, const_cast<uchar*>(payload)), IMREAD_UNCHANGED);
+    }
+    if ((size_t)entry.cropWidth * entry.cropHeight * entry.channels != entry.length) {
+        return Mat();
+    }
+    return Mat(entry.cropHeight, entry.cropWidth, CV_8UC(entry.channels), const_cast<uchar*>(payload));
+}
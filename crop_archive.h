@@ -0,0 +1,135 @@
+#ifndef CROP_ARCHIVE_H
+#define CROP_ARCHIVE_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace cv;
+
+//arhiva de decupaje append-only: in loc de un fisier (si un JPEG) per placuta, decupajele se
+//adauga la coada unui fisier segment-NNNNNN.dat, iar segment-NNNNNN.idx primeste cate o intrare
+//de lungime fixa. Intrarea se scrie dupa date, deci un index citit pana la ultima intrare
+//completa trimite mereu la date complete. Segmentul se inchide la segmentBytes.
+
+const uint32_t CROP_DATA_MAGIC = 0x4C505244; // "LPRD"
+const uint32_t CROP_INDEX_MAGIC = 0x4C505249; // "LPRI"
+const uint32_t CROP_ARCHIVE_VERSION = 1;
+const size_t CROP_FILE_HEADER_BYTES = 64;
+
+enum class CropEncoding : uint8_t {
+    RAW = 0, //randurile compacte, fara stride
+    JPEG = 1
+};
+
+struct CropFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t segment;
+    uint32_t reserved[13];
+};
+
+struct CropIndexEntry {
+    uint64_t frameId;
+    int64_t timestampNs;
+    int32_t x, y, width, height; //placuta, in coordonatele cadrului
+    uint64_t offset; //in fisierul .dat al aceluiasi segment
+    uint32_t length;
+    uint16_t cropWidth, cropHeight;
+    uint8_t channels;
+    uint8_t encoding; //CropEncoding
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(CropFileHeader) == CROP_FILE_HEADER_BYTES, "crop file header must stay 64 bytes");
+static_assert(sizeof(CropIndexEntry) == 56, "crop index entries are fixed-size on disk");
+
+//un decupaj pregatit pentru scriere: intrarea de index (offset completat la scriere) si
+//payload-ul deja compactat (RAW) sau codat (JPEG)
+struct CropRecord {
+    CropIndexEntry entry;
+    vector<uchar> payload;
+};
+
+struct ArchiveConfig {
+    string directory = "crops";
+    uint64_t segmentBytes = 256ull << 20;
+    CropEncoding encoding = CropEncoding::RAW;
+    int jpegQuality = 90;
+};
+
+class CropArchiveWriter {
+public:
+    CropArchiveWriter() : data(nullptr), index(nullptr), segment(0), offset(0), written(0) {}
+    ~CropArchiveWriter();
+    CropArchiveWriter(const CropArchiveWriter&) = delete;
+    CropArchiveWriter& operator=(const CropArchiveWriter&) = delete;
+
+    //continua dupa ultimul segment existent din director
+    bool open(const ArchiveConfig& config);
+    void close();
+    bool append(uint64_t frameId, int64_t timestampNs, const MyRect& box, const Mat& crop);
+    //compactarea / codarea, separata de scriere ca sa poata rula pe alt thread decat detectia
+    bool prepare(uint64_t frameId, int64_t timestampNs, const MyRect& box, const Mat& crop, CropRecord& record) const;
+    //toate payload-urile, un flush, apoi toate intrarile de index
+    bool write(vector<CropRecord>& records);
+    void flush();
+    //flush + fsync pe .dat si .idx
+    void sync();
+
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    bool openSegment(uint32_t number);
+    bool abandonSegment();
+
+    ArchiveConfig config;
+    FILE* data;
+    FILE* index;
+    uint32_t segment;
+    uint64_t offset; //urmatorul octet din .dat
+    uint64_t written;
+};
+
+//cititor prin mmap: toate indexurile sunt mapate si sortate dupa frameId, iar decupajele RAW
+//sunt intoarse ca Mat direct peste maparea segmentului (fara copiere)
+class CropArchiveReader {
+public:
+    struct Location {
+        const CropIndexEntry* entry;
+        int segment; //pozitia in segments, nu numarul fisierului
+    };
+
+    CropArchiveReader() {}
+    ~CropArchiveReader();
+    CropArchiveReader(const CropArchiveReader&) = delete;
+    CropArchiveReader& operator=(const CropArchiveReader&) = delete;
+
+    bool open(const string& directory);
+    void close();
+
+    size_t size() const { return locations.size(); }
+    //toate decupajele unui cadru, in O(log n)
+    vector<Location> find(uint64_t frameId) const;
+    const vector<Location>& all() const { return locations; }
+    //RAW: vedere peste mapare, valida cat timp cititorul e deschis; JPEG: decodat
+    Mat crop(const Location& location) const;
+
+private:
+    struct MappedFile {
+        const uchar* data = nullptr;
+        size_t bytes = 0;
+        vector<uchar> fallback; //fara mmap (Windows), fisierul citit in memorie
+    };
+
+    bool mapFile(const string& path, MappedFile& file);
+    void unmapFile(MappedFile& file);
+
+    vector<MappedFile> segments;
+    vector<MappedFile> indexes;
+    vector<Location> locations;
+};
+
+#endif
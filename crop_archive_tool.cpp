@@ -0,0 +1,50 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "crop_archive.h"
+#include <string>
+
+//citeste arhiva de decupaje: fara --frame afiseaza un rezumat, cu --frame scrie decupajele
+//cadrului respectiv (gasite prin index, fara scanarea segmentelor)
+int main(int argc, char** argv) {
+    std::string directory = "crops";
+    long long frameId = -1;
+    std::string outPrefix = "crop";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--dir") directory = value;
+        else if (key == "--frame") frameId = std::stoll(value);
+        else if (key == "--out") outPrefix = value;
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+
+    CropArchiveReader reader;
+    if (!reader.open(directory)) {
+        std::cerr << "No archive segments in " << directory << std::endl;
+        return -1;
+    }
+
+    if (frameId < 0) {
+        const auto& all = reader.all();
+        std::cout << all.size() << " crops";
+        if (!all.empty()) {
+            std::cout << ", frames " << all.front().entry->frameId << " to " << all.back().entry->frameId;
+        }
+        std::cout << std::endl;
+        return 0;
+    }
+
+    std::vector<CropArchiveReader::Location> found = reader.find((uint64_t)frameId);
+    if (found.empty()) {
+        std::cerr << "No crops for frame " << frameId << std::endl;
+        return 1;
+    }
+    for (size_t i = 0; i < found.size(); i++) {
+        const CropIndexEntry& entry = *found[i].entry;
+        std::string path = outPrefix + "_" + std::to_string(frameId) + "_" + std::to_string(i) + ".png";
+        cv::imwrite(path, reader.crop(found[i]));
+        std::cout << path << ": box " << entry.x << "," << entry.y << " " << entry.width << "x" << entry.height
+                  << ", timestamp " << entry.timestampNs << std::endl;
+    }
+    return 0;
+}
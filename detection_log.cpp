@@ -0,0 +1,427 @@
+#include "detection_log.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static size_t columnBytes(size_t rows, size_t elementSize) {
+    return (rows * elementSize + 63) / 64 * 64;
+}
+
+static void writeColumn(FILE* file, const void* data, size_t rows, size_t elementSize) {
+    static const uchar zeros[64] = {};
+    size_t bytes = rows * elementSize;
+    fwrite(data, 1, bytes, file);
+    fwrite(zeros, 1, columnBytes(rows, elementSize) - bytes, file);
+}
+
+static uint64_t payloadBytesFor(uint64_t rows, uint32_t stageCount) {
+    return 2 * columnBytes(rows, 8) + (6 + (uint64_t)stageCount) * columnBytes(rows, 4);
+}
+
+//parcurge headerele blocurilor de la primul si se opreste la primul bloc invalid sau incomplet
+//(coada unei scrieri intrerupte, sau footer-ul); intoarce offset-ul de dupa ultimul bloc complet
+template <typename ReadAt>
+static uint64_t scanBlocks(ReadAt readAt, uint64_t size, uint32_t stageCount, vector<DetectionBlockInfo>& blocks,
+                           uint64_t& rows) {
+    uint64_t position = sizeof(DetectionLogHeader);
+    DetectionBlockHeader header;
+    while (position + sizeof(header) <= size && readAt(position, &header, sizeof(header))) {
+        if (header.magic != DETECTION_BLOCK_MAGIC || header.rows == 0 ||
+            header.payloadBytes != payloadBytesFor(header.rows, stageCount) ||
+            position + sizeof(header) + header.payloadBytes > size) {
+            break;
+        }
+        DetectionBlockInfo info = {};
+        info.offset = position + sizeof(header);
+        info.rows = header.rows;
+        info.minTimestampNs = header.minTimestampNs;
+        info.maxTimestampNs = header.maxTimestampNs;
+        info.minCamera = header.minCamera;
+        info.maxCamera = header.maxCamera;
+        blocks.push_back(info);
+        rows += header.rows;
+        position = info.offset + header.payloadBytes;
+    }
+    return position;
+}
+
+//trailer-ul unui fisier inchis corect, verificat fata de dimensiunea fisierului
+static bool validTrailer(const DetectionLogTrailer& trailer, uint64_t size) {
+    return trailer.magic == DETECTION_LOG_MAGIC && trailer.version == DETECTION_LOG_VERSION &&
+           trailer.footerOffset >= sizeof(DetectionLogHeader) &&
+           trailer.footerOffset + (uint64_t)trailer.blockCount * sizeof(DetectionBlockInfo) +
+           sizeof(DetectionLogTrailer) == size;
+}
+
+DetectionLogWriter::~DetectionLogWriter() {
+    close();
+}
+
+bool DetectionLogWriter::open(const string& path, uint32_t _blockRows) {
+    close();
+    blockRows = max(1u, _blockRows);
+    totalRows = 0;
+    blocks.clear();
+    stages.assign(STAGE_COUNT, vector<uint32_t>());
+
+    error_code error;
+    uint64_t size = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+    if (size > 0) {
+        return resume(path, size);
+    }
+
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Could not create detection log " << path << std::endl;
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    DetectionLogHeader header = {};
+    header.magic = DETECTION_LOG_MAGIC;
+    header.version = DETECTION_LOG_VERSION;
+    header.blockRows = blockRows;
+    header.stageCount = STAGE_COUNT;
+    header.clock = DETECTION_CLOCK_UNIX_NS;
+    fwrite(&header, sizeof(header), 1, file);
+    offset = sizeof(header);
+    return true;
+}
+
+//fisier existent: indexul din footer (daca a fost inchis) sau din headerele blocurilor; ce e dupa
+//ultimul bloc complet (footer, bloc scris pe jumatate) e taiat si scrierea continua de acolo
+bool DetectionLogWriter::resume(const string& path, uint64_t size) {
+    FILE* in = fopen(path.c_str(), "rb");
+    DetectionLogHeader header = {};
+    if (in == nullptr || fread(&header, sizeof(header), 1, in) != 1 || header.magic != DETECTION_LOG_MAGIC ||
+        header.version != DETECTION_LOG_VERSION || header.stageCount != STAGE_COUNT) {
+        std::cerr << "Detection log " << path << " exists with another format; not overwriting it" << std::endl;
+        if (in != nullptr) {
+            fclose(in);
+        }
+        return false;
+    }
+    auto readAt = [&](uint64_t position, void* out, size_t bytes) {
+        return fseek(in, (long)position, SEEK_SET) == 0 && fread(out, bytes, 1, in) == 1;
+    };
+
+    uint64_t end;
+    DetectionLogTrailer trailer = {};
+    if (size >= sizeof(header) + sizeof(trailer) && readAt(size - sizeof(trailer), &trailer, sizeof(trailer)) &&
+        validTrailer(trailer, size)) {
+        blocks.resize(trailer.blockCount);
+        if (trailer.blockCount > 0 &&
+            !readAt(trailer.footerOffset, blocks.data(), blocks.size() * sizeof(DetectionBlockInfo))) {
+            blocks.clear();
+        }
+        for (const auto& block : blocks) {
+            totalRows += block.rows;
+        }
+        end = trailer.footerOffset;
+    } else {
+        end = scanBlocks(readAt, size, header.stageCount, blocks, totalRows);
+    }
+    fclose(in);
+
+    error_code error;
+    std::filesystem::resize_file(path, end, error);
+    file = error ? nullptr : fopen(path.c_str(), "r+b");
+    if (file == nullptr || fseek(file, 0, SEEK_END) != 0) {
+        std::cerr << "Could not reopen detection log " << path << std::endl;
+        close();
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    offset = end;
+    return true;
+}
+
+void DetectionLogWriter::append(const DetectionRecord& record) {
+    if (file == nullptr) {
+        return;
+    }
+    frameIds.push_back(record.frameId);
+    timestamps.push_back(record.timestampNs);
+    cameras.push_back(record.cameraId);
+    xs.push_back(record.rect.x);
+    ys.push_back(record.rect.y);
+    widths.push_back(record.rect.width);
+    heights.push_back(record.rect.height);
+    scores.push_back(record.score);
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        stages[s].push_back(record.stageMicros[s]);
+    }
+    if (frameIds.size() >= blockRows) {
+        writeBlock();
+    }
+}
+
+void DetectionLogWriter::writeBlock() {
+    size_t rows = frameIds.size();
+    if (rows == 0) {
+        return;
+    }
+    DetectionBlockHeader header = {};
+    header.magic = DETECTION_BLOCK_MAGIC;
+    header.rows = (uint32_t)rows;
+    header.payloadBytes = payloadBytesFor(rows, STAGE_COUNT);
+    header.minTimestampNs = *min_element(timestamps.begin(), timestamps.end());
+    header.maxTimestampNs = *max_element(timestamps.begin(), timestamps.end());
+    header.minCamera = *min_element(cameras.begin(), cameras.end());
+    header.maxCamera = *max_element(cameras.begin(), cameras.end());
+    fwrite(&header, sizeof(header), 1, file);
+
+    DetectionBlockInfo info = {};
+    info.offset = offset + sizeof(header);
+    info.rows = header.rows;
+    info.minTimestampNs = header.minTimestampNs;
+    info.maxTimestampNs = header.maxTimestampNs;
+    info.minCamera = header.minCamera;
+    info.maxCamera = header.maxCamera;
+
+    writeColumn(file, frameIds.data(), rows, sizeof(uint64_t));
+    writeColumn(file, timestamps.data(), rows, sizeof(int64_t));
+    writeColumn(file, cameras.data(), rows, sizeof(uint32_t));
+    writeColumn(file, xs.data(), rows, sizeof(int32_t));
+    writeColumn(file, ys.data(), rows, sizeof(int32_t));
+    writeColumn(file, widths.data(), rows, sizeof(int32_t));
+    writeColumn(file, heights.data(), rows, sizeof(int32_t));
+    writeColumn(file, scores.data(), rows, sizeof(float));
+    for (auto& stage : stages) {
+        writeColumn(file, stage.data(), rows, sizeof(uint32_t));
+    }
+    offset = info.offset + header.payloadBytes;
+    totalRows += rows;
+    blocks.push_back(info);
+
+    frameIds.clear();
+    timestamps.clear();
+    cameras.clear();
+    xs.clear();
+    ys.clear();
+    widths.clear();
+    heights.clear();
+    scores.clear();
+    for (auto& stage : stages) {
+        stage.clear();
+    }
+}
+
+void DetectionLogWriter::flush() {
+    if (file == nullptr) {
+        return;
+    }
+    writeBlock();
+    fflush(file);
+}
+
+void DetectionLogWriter::sync() {
+    if (file == nullptr) {
+        return;
+    }
+    flush();
+#ifndef _WIN32
+    ::fsync(fileno(file));
+#endif
+}
+
+bool DetectionLogWriter::close() {
+    if (file == nullptr) {
+        return false;
+    }
+    writeBlock();
+    DetectionLogTrailer trailer = {};
+    trailer.footerOffset = offset;
+    trailer.totalRows = totalRows;
+    trailer.blockCount = (uint32_t)blocks.size();
+    trailer.version = DETECTION_LOG_VERSION;
+    trailer.magic = DETECTION_LOG_MAGIC;
+    if (!blocks.empty()) {
+        fwrite(blocks.data(), sizeof(DetectionBlockInfo), blocks.size(), file);
+    }
+    fwrite(&trailer, sizeof(trailer), 1, file);
+    bool ok = fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+DetectionLogReader::~DetectionLogReader() {
+    close();
+}
+
+bool DetectionLogReader::open(const string& path) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open detection log " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(DetectionLogHeader)) {
+        ::close(fd);
+        std::cerr << "Detection log " << path << " is truncated" << std::endl;
+        return false;
+    }
+    void* memory = ::mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    mapped = static_cast<const uchar*>(memory);
+    mappedBytes = (size_t)info.st_size;
+#else
+    std::ifstream in(path, std::ios::binary);
+    fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (fallback.size() < sizeof(DetectionLogHeader)) {
+        std::cerr << "Detection log " << path << " is truncated" << std::endl;
+        return false;
+    }
+    mapped = fallback.data();
+    mappedBytes = fallback.size();
+#endif
+
+    header = reinterpret_cast<const DetectionLogHeader*>(mapped);
+    if (header->magic != DETECTION_LOG_MAGIC || header->version != DETECTION_LOG_VERSION) {
+        std::cerr << "Detection log " << path << " has an unknown format" << std::endl;
+        close();
+        return false;
+    }
+    const DetectionLogTrailer* trailer = nullptr;
+    if (mappedBytes >= sizeof(DetectionLogHeader) + sizeof(DetectionLogTrailer)) {
+        trailer = reinterpret_cast<const DetectionLogTrailer*>(mapped + mappedBytes - sizeof(DetectionLogTrailer));
+    }
+    closed = trailer != nullptr && validTrailer(*trailer, mappedBytes);
+    if (closed) {
+        const DetectionBlockInfo* footer = reinterpret_cast<const DetectionBlockInfo*>(mapped + trailer->footerOffset);
+        blocks.assign(footer, footer + trailer->blockCount);
+        totalRows = trailer->totalRows;
+    } else {
+        //fisier neinchis: blocurile complete, gasite prin headerele lor
+        auto readAt = [&](uint64_t position, void* out, size_t bytes) {
+            memcpy(out, mapped + position, bytes);
+            return true;
+        };
+        scanBlocks(readAt, mappedBytes, header->stageCount, blocks, totalRows);
+    }
+    return true;
+}
+
+void DetectionLogReader::close() {
+#ifndef _WIN32
+    if (mapped != nullptr && fallback.empty()) {
+        ::munmap(const_cast<uchar*>(mapped), mappedBytes);
+    }
+#endif
+    fallback.clear();
+    mapped = nullptr;
+    mappedBytes = 0;
+    header = nullptr;
+    blocks.clear();
+    totalRows = 0;
+    closed = false;
+}
+
+DetectionLogReader::Block DetectionLogReader::block(size_t index) const {
+    Block block;
+    const DetectionBlockInfo& info = blocks[index];
+    size_t rows = info.rows;
+    const uchar* p = mapped + info.offset;
+    block.info = &info;
+    block.rows = info.rows;
+    block.frameId = reinterpret_cast<const uint64_t*>(p);
+    p += columnBytes(rows, 8);
+    block.timestampNs = reinterpret_cast<const int64_t*>(p);
+    p += columnBytes(rows, 8);
+    block.cameraId = reinterpret_cast<const uint32_t*>(p);
+    p += columnBytes(rows, 4);
+    block.x = reinterpret_cast<const int32_t*>(p);
+    p += columnBytes(rows, 4);
+    block.y = reinterpret_cast<const int32_t*>(p);
+    p += columnBytes(rows, 4);
+    block.width = reinterpret_cast<const int32_t*>(p);
+    p += columnBytes(rows, 4);
+    block.height = reinterpret_cast<const int32_t*>(p);
+    p += columnBytes(rows, 4);
+    block.score = reinterpret_cast<const float*>(p);
+    p += columnBytes(rows, 4);
+    block.stageMicros = reinterpret_cast<const uint32_t*>(p);
+    block.columnStride = columnBytes(rows, 4) / sizeof(uint32_t);
+    return block;
+}
+
+int DetectionLogReader::classify(const DetectionBlockInfo& info, const DetectionQuery& query) const {
+    if (info.maxTimestampNs < query.fromNs || info.minTimestampNs >= query.toNs) {
+        return 0;
+    }
+    if (query.camera >= 0 && (query.camera < info.minCamera || query.camera > info.maxCamera)) {
+        return 0;
+    }
+    bool timeInside = info.minTimestampNs >= query.fromNs && info.maxTimestampNs < query.toNs;
+    bool cameraInside = query.camera < 0 || (info.minCamera == query.camera && info.maxCamera == query.camera);
+    return timeInside && cameraInside ? 2 : 1;
+}
+
+//bucla fara ramificatii: comparatiile devin 0/1 si se aduna, deci compilatorul o vectorizeaza
+//si scanarea e limitata de latimea de banda a memoriei, nu de predictia salturilor
+uint64_t DetectionLogReader::count(const DetectionQuery& query, uint64_t* scannedBytes) const {
+    uint64_t total = 0;
+    uint64_t scanned = 0;
+    for (size_t b = 0; b < blockCount(); b++) {
+        int match = classify(blocks[b], query);
+        if (match == 0) {
+            continue;
+        }
+        if (match == 2) {
+            total += blocks[b].rows;
+            continue;
+        }
+        Block block = this->block(b);
+        const int64_t* timestamps = block.timestampNs;
+        const uint32_t* cameras = block.cameraId;
+        int64_t from = query.fromNs, to = query.toNs;
+        uint64_t matched = 0;
+        if (query.camera < 0) {
+            for (uint32_t r = 0; r < block.rows; r++) {
+                matched += (uint64_t)((timestamps[r] >= from) & (timestamps[r] < to));
+            }
+            scanned += (uint64_t)block.rows * sizeof(int64_t);
+        } else {
+            uint32_t camera = (uint32_t)query.camera;
+            for (uint32_t r = 0; r < block.rows; r++) {
+                matched += (uint64_t)((timestamps[r] >= from) & (timestamps[r] < to) & (cameras[r] == camera));
+            }
+            scanned += (uint64_t)block.rows * (sizeof(int64_t) + sizeof(uint32_t));
+        }
+        total += matched;
+    }
+    if (scannedBytes != nullptr) {
+        *scannedBytes = scanned;
+    }
+    return total;
+}
+
+vector<pair<uint32_t, uint32_t>> DetectionLogReader::filter(const DetectionQuery& query) const {
+    vector<pair<uint32_t, uint32_t>> rows;
+    for (size_t b = 0; b < blockCount(); b++) {
+        int match = classify(blocks[b], query);
+        if (match == 0) {
+            continue;
+        }
+        Block block = this->block(b);
+        for (uint32_t r = 0; r < block.rows; r++) {
+            if (match == 2 || (block.timestampNs[r] >= query.fromNs && block.timestampNs[r] < query.toNs &&
+                               (query.camera < 0 || block.cameraId[r] == (uint32_t)query.camera))) {
+                rows.emplace_back((uint32_t)b, r);
+            }
+        }
+    }
+    return rows;
+}
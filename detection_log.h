@@ -0,0 +1,176 @@
+#ifndef DETECTION_LOG_H
+#define DETECTION_LOG_H
+#include "proj.h"
+#include "metrics.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+
+//jurnal binar pe coloane pentru rapoarte peste sute de milioane de detectii. Fisierul are un
+//header de 64 de octeti, blocuri de cel mult blockRows randuri si, daca a fost inchis, un index
+//(footer): pentru fiecare bloc offset-ul, numarul de randuri si intervalele de timestamp/camera,
+//ca interogarile sa poata sari blocuri intregi. Fiecare bloc incepe cu propriul header, deci un
+//fisier neinchis (crash, kill) se citeste parcurgand headerele, pana la ultimul bloc complet; la
+//redeschidere scriitorul continua dupa acest bloc (fara sa stearga ce exista).
+//In bloc, fiecare coloana (latime fixa) e contigua si aliniata la 64 de octeti, in ordinea:
+//frameId, timestampNs, cameraId, x, y, width, height, score, apoi cate o coloana de
+//microsecunde pentru fiecare etapa.
+
+const uint32_t DETECTION_LOG_MAGIC = 0x4C50524C; // "LPRL"
+const uint32_t DETECTION_BLOCK_MAGIC = 0x4C505242; // "LPRB"
+const uint32_t DETECTION_LOG_VERSION = 2;
+const uint32_t DETECTION_CLOCK_UNIX_NS = 1; //timestampNs = nanosecunde de la epoca Unix (system_clock)
+
+struct DetectionLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t blockRows;
+    uint32_t stageCount; //STAGE_COUNT la scriere; cititorul nu depinde de enum-ul curent
+    uint32_t clock; //DETECTION_CLOCK_UNIX_NS
+    uint32_t reserved[11];
+};
+
+struct DetectionBlockHeader {
+    uint32_t magic; //DETECTION_BLOCK_MAGIC
+    uint32_t rows;
+    uint64_t payloadBytes; //coloanele care urmeaza, ca blocul sa poata fi sarit
+    int64_t minTimestampNs, maxTimestampNs;
+    uint32_t minCamera, maxCamera;
+    uint32_t reserved[6];
+};
+
+struct DetectionBlockInfo {
+    uint64_t offset; //prima coloana, imediat dupa DetectionBlockHeader
+    uint32_t rows;
+    uint32_t reserved;
+    int64_t minTimestampNs, maxTimestampNs;
+    uint32_t minCamera, maxCamera;
+};
+
+//ultimii 32 de octeti ai fisierului
+struct DetectionLogTrailer {
+    uint64_t footerOffset;
+    uint64_t totalRows;
+    uint32_t blockCount;
+    uint32_t version;
+    uint32_t reserved;
+    uint32_t magic; //ultimul: un fisier fara magic la coada nu a fost inchis
+};
+
+static_assert(sizeof(DetectionLogHeader) == 64, "detection log header must stay 64 bytes");
+static_assert(sizeof(DetectionBlockHeader) == 64, "detection block header must stay 64 bytes");
+static_assert(sizeof(DetectionBlockInfo) == 40, "detection block info is fixed-size on disk");
+static_assert(sizeof(DetectionLogTrailer) == 32, "detection log trailer is fixed-size on disk");
+
+//o placuta detectata; timpii pe etape sunt ai cadrului din care provine
+struct DetectionRecord {
+    uint64_t frameId = 0;
+    int64_t timestampNs = 0;
+    uint32_t cameraId = 0;
+    MyRect rect;
+    float score = 0.0f;
+    uint32_t stageMicros[STAGE_COUNT] = {};
+};
+
+class DetectionLogWriter {
+public:
+    DetectionLogWriter() : file(nullptr), blockRows(0), offset(0), totalRows(0) {}
+    ~DetectionLogWriter();
+    DetectionLogWriter(const DetectionLogWriter&) = delete;
+    DetectionLogWriter& operator=(const DetectionLogWriter&) = delete;
+
+    //un fisier existent e continuat dupa ultimul bloc complet (footer-ul vechi e eliminat)
+    bool open(const string& path, uint32_t blockRows = 65536);
+    //randurile se strang in memorie; un bloc plin e scris dintr-o data
+    void append(const DetectionRecord& record);
+    //randurile din memorie devin un bloc (eventual mai scurt) si ajung la kernel
+    void flush();
+    //flush + fsync
+    void sync();
+    //ultimul bloc, footer-ul si trailer-ul; fara close() fisierul se citeste prin headerele blocurilor
+    bool close();
+
+private:
+    void writeBlock();
+    bool resume(const string& path, uint64_t size);
+
+    FILE* file;
+    uint32_t blockRows;
+    uint64_t offset;
+    uint64_t totalRows;
+    vector<DetectionBlockInfo> blocks;
+
+    vector<uint64_t> frameIds;
+    vector<int64_t> timestamps;
+    vector<uint32_t> cameras;
+    vector<int32_t> xs, ys, widths, heights;
+    vector<float> scores;
+    vector<vector<uint32_t>> stages;
+};
+
+//intervalul [fromNs, toNs) si o camera (-1 = oricare)
+struct DetectionQuery {
+    int64_t fromNs = INT64_MIN;
+    int64_t toNs = INT64_MAX;
+    int64_t camera = -1;
+};
+
+//cititor zero-copy: fisierul e mapat, iar coloanele unui bloc sunt pointeri direct in mapare
+class DetectionLogReader {
+public:
+    struct Block {
+        uint32_t rows = 0;
+        const uint64_t* frameId = nullptr;
+        const int64_t* timestampNs = nullptr;
+        const uint32_t* cameraId = nullptr;
+        const int32_t* x = nullptr;
+        const int32_t* y = nullptr;
+        const int32_t* width = nullptr;
+        const int32_t* height = nullptr;
+        const float* score = nullptr;
+        const uint32_t* stageMicros = nullptr; //stageCount coloane de cate rows valori, una dupa alta
+        const DetectionBlockInfo* info = nullptr;
+
+        const uint32_t* stage(int s) const { return stageMicros + (size_t)s * columnStride; }
+        size_t columnStride = 0; //in elemente uint32
+    };
+
+    DetectionLogReader() : mapped(nullptr), mappedBytes(0), header(nullptr) {}
+    ~DetectionLogReader();
+    DetectionLogReader(const DetectionLogReader&) = delete;
+    DetectionLogReader& operator=(const DetectionLogReader&) = delete;
+
+    bool open(const string& path);
+    void close();
+
+    size_t blockCount() const { return blocks.size(); }
+    uint64_t rowCount() const { return totalRows; }
+    //false daca fisierul nu a fost inchis si indexul a fost refacut din headerele blocurilor
+    bool wasClosed() const { return closed; }
+    uint32_t stageCount() const { return header != nullptr ? header->stageCount : 0; }
+    //epoca timestamp-urilor, DETECTION_CLOCK_UNIX_NS
+    uint32_t clock() const { return header != nullptr ? header->clock : 0; }
+    Block block(size_t index) const;
+
+    //blocurile complet in afara interogarii sunt sarite dupa footer, cele complet inauntru sunt
+    //numarate fara sa fie citite; restul sunt scanate fara ramificatii pe coloanele de timp si camera
+    uint64_t count(const DetectionQuery& query, uint64_t* scannedBytes = nullptr) const;
+    //randurile care se potrivesc, ca perechi (bloc, rand)
+    vector<pair<uint32_t, uint32_t>> filter(const DetectionQuery& query) const;
+
+private:
+    //0 = blocul nu se potriveste deloc, 1 = partial, 2 = complet
+    int classify(const DetectionBlockInfo& info, const DetectionQuery& query) const;
+
+    const uchar* mapped;
+    size_t mappedBytes;
+    vector<uchar> fallback; //fara mmap (Windows), fisierul citit in memorie
+    const DetectionLogHeader* header;
+    vector<DetectionBlockInfo> blocks; //din footer sau refacut din headerele blocurilor
+    uint64_t totalRows = 0;
+    bool closed = false;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include <iostream>
+#include "detection_log.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+//interogari pe jurnalul binar de detectii: count (implicit), list sau stats (media pe etape)
+//pentru intervalul [--from, --to) in nanosecunde de la epoca Unix si optional o camera
+int main(int argc, char** argv) {
+    std::string path;
+    std::string mode = "count";
+    DetectionQuery query;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--log") path = value;
+        else if (key == "--mode") mode = value;
+        else if (key == "--from") query.fromNs = std::stoll(value);
+        else if (key == "--to") query.toNs = std::stoll(value);
+        else if (key == "--camera") query.camera = std::stoll(value);
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: detection_log_tool --log file [--mode count|list|stats] [--from unix_ns] [--to unix_ns] [--camera id]"
+                  << std::endl;
+        return -1;
+    }
+
+    DetectionLogReader reader;
+    if (!reader.open(path)) {
+        return -1;
+    }
+    if (reader.clock() != DETECTION_CLOCK_UNIX_NS) {
+        std::cerr << "Warning: " << path << " does not use Unix timestamps; --from/--to may not match" << std::endl;
+    }
+
+    if (mode == "count") {
+        uint64_t scanned = 0;
+        Clock::time_point start = Clock::now();
+        uint64_t matched = reader.count(query, &scanned);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("%llu of %llu detections match (%zu blocks)\n", (unsigned long long)matched,
+               (unsigned long long)reader.rowCount(), reader.blockCount());
+        if (scanned > 0 && seconds > 0) {
+            printf("scanned %.1f MB in %.3f ms (%.2f GB/s)\n", scanned / 1e6, seconds * 1e3, scanned / seconds / 1e9);
+        }
+        return 0;
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> rows = reader.filter(query);
+    if (mode == "list") {
+        printf("frame,timestamp_ns,camera,x,y,width,height,score\n");
+        for (const auto& [b, r] : rows) {
+            DetectionLogReader::Block block = reader.block(b);
+            printf("%llu,%lld,%u,%d,%d,%d,%d,%.3f\n", (unsigned long long)block.frameId[r],
+                   (long long)block.timestampNs[r], block.cameraId[r], block.x[r], block.y[r], block.width[r],
+                   block.height[r], block.score[r]);
+        }
+    } else if (mode == "stats") {
+        std::vector<double> sums(reader.stageCount(), 0.0);
+        for (const auto& [b, r] : rows) {
+            DetectionLogReader::Block block = reader.block(b);
+            for (uint32_t s = 0; s < reader.stageCount(); s++) {
+                sums[s] += block.stage(s)[r];
+            }
+        }
+        printf("%zu detections\n", rows.size());
+        for (uint32_t s = 0; s < reader.stageCount() && !rows.empty(); s++) {
+            //numele etapelor sunt valabile doar daca jurnalul a fost scris cu acelasi enum
+            const char* name = reader.stageCount() == STAGE_COUNT ? stageName((PipelineStage)s) : "stage";
+            printf("%-14s %10.1f us\n", name, sums[s] / rows.size());
+        }
+    } else {
+        std::cerr << "Unknown mode " << mode << std::endl;
+        return -1;
+    }
+    return 0;
+}
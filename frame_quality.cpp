@@ -0,0 +1,69 @@
+#include "frame_quality.h"
+#include "proj.h"
+#include "metrics.h"
+#include <chrono>
+
+FrameQualityGate::FrameQualityGate() : FrameQualityGate(QualityGateConfig()) {
+}
+
+FrameQualityGate::FrameQualityGate(const QualityGateConfig& _config) : config(_config) {
+}
+
+//o trecere pe cadrul redus: histograma pe toti pixelii si, pe interior,
+//L = 4c - sus - jos - stanga - dreapta, cu suma si suma patratelor in intregi
+FrameQuality FrameQualityGate::evaluate(const Mat& frame) {
+    auto start = std::chrono::steady_clock::now();
+    FrameQuality quality;
+    {
+        StageTimer timer(STAGE_QUALITY_GATE);
+        Mat luma = LicensePlateDetector::decimatedLuma(frame, config.analysisWidth);
+
+        long long histogram[256] = {};
+        long long lapSum = 0, lapSquares = 0, lapCount = 0;
+        for (int i = 0; i < luma.rows; i++) {
+            const uchar* row = luma.ptr<uchar>(i);
+            for (int j = 0; j < luma.cols; j++) {
+                histogram[row[j]]++;
+            }
+            if (i == 0 || i == luma.rows - 1) {
+                continue;
+            }
+            const uchar* up = luma.ptr<uchar>(i - 1);
+            const uchar* down = luma.ptr<uchar>(i + 1);
+            for (int j = 1; j < luma.cols - 1; j++) {
+                int lap = 4 * row[j] - up[j] - down[j] - row[j - 1] - row[j + 1];
+                lapSum += lap;
+                lapSquares += lap * lap;
+            }
+            lapCount += max(0, luma.cols - 2);
+        }
+
+        long long total = (long long)luma.rows * luma.cols;
+        if (total > 0) {
+            long long lumaSum = 0, bright = 0, dark = 0;
+            for (int v = 0; v < 256; v++) {
+                lumaSum += histogram[v] * v;
+                if (v >= config.brightLevel) bright += histogram[v];
+                if (v <= config.darkLevel) dark += histogram[v];
+            }
+            quality.meanLuma = (double)lumaSum / total;
+            quality.brightFraction = (double)bright / total;
+            quality.darkFraction = (double)dark / total;
+        }
+        if (lapCount > 0) {
+            double mean = (double)lapSum / lapCount;
+            quality.sharpness = (double)lapSquares / lapCount - mean * mean;
+        }
+        quality.acceptable = quality.sharpness >= config.minSharpness &&
+                             quality.brightFraction <= config.maxBrightFraction &&
+                             quality.darkFraction <= config.maxDarkFraction;
+    }
+
+    evaluated++;
+    if (!quality.acceptable) {
+        rejected++;
+        Metrics::increment(COUNTER_QUALITY_REJECTED_FRAMES);
+    }
+    totalNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return quality;
+}
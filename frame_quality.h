@@ -0,0 +1,51 @@
+#ifndef FRAME_QUALITY_H
+#define FRAME_QUALITY_H
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+using namespace std;
+using namespace cv;
+
+struct QualityGateConfig {
+    int analysisWidth = 160; //ca la MotionGate: cadrul e redus (medie pe blocuri) pana la latimea asta
+    double minSharpness = 30.0; //varianta Laplacianului pe cadrul redus; sub ea cadrul e neclar
+    int brightLevel = 250; //pixelii de la nivelul asta in sus sunt considerati saturati
+    int darkLevel = 8;
+    double maxBrightFraction = 0.35;
+    double maxDarkFraction = 0.6;
+};
+
+//masuratorile unui cadru si verdictul portii
+class FrameQuality {
+public:
+    double sharpness; //varianta Laplacianului (4 vecini)
+    double meanLuma;
+    double brightFraction; //din histograma luminantei
+    double darkFraction;
+    bool acceptable;
+
+    FrameQuality() : sharpness(0.0), meanLuma(0.0), brightFraction(0.0), darkFraction(0.0), acceptable(true) {}
+};
+
+//poarta de calitate inainte de detectie: cadrele neclare (miscare, focus) sau supra/sub-expuse
+//nu merita tot pipeline-ul si produc candidate false. Ruleaza pe luminanta redusa, intr-o
+//singura trecere (Laplacian + histograma). Pastreaza costul si rata de respingere.
+class FrameQualityGate {
+public:
+    FrameQualityGate();
+    explicit FrameQualityGate(const QualityGateConfig& config);
+
+    FrameQuality evaluate(const Mat& frame);
+
+    long long evaluatedFrames() const { return evaluated; }
+    long long rejectedFrames() const { return rejected; }
+    double rejectionRate() const { return evaluated > 0 ? (double)rejected / evaluated : 0.0; }
+    double averageCostMs() const { return evaluated > 0 ? totalNanos / 1e6 / evaluated : 0.0; }
+
+private:
+    QualityGateConfig config;
+    long long evaluated = 0;
+    long long rejected = 0;
+    uint64_t totalNanos = 0;
+};
+
+#endif
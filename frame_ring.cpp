@@ -0,0 +1,208 @@
+#include "frame_ring.h"
+#include <iostream>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//headerul inelului ocupa o pagina; fiecare slot incepe aliniat la 64 de octeti
+//si datele cadrului incep la 64 de octeti dupa inceputul slotului
+static const size_t RING_HEADER_BYTES = 4096;
+static const size_t FRAME_DATA_OFFSET = 64;
+
+static_assert(sizeof(FrameHeader) <= FRAME_DATA_OFFSET, "FrameHeader must fit before the frame data");
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+//octetii de care are nevoie vederea Mat a cadrului (primul plan), 0 daca headerul e invalid
+static uint64_t frameExtent(const FrameHeader& frame) {
+    if (frame.format > (uint32_t)FrameFormat::I420 || frame.height == 0) {
+        return 0;
+    }
+    uint64_t rowBytes = (uint64_t)frame.width * (frame.format == (uint32_t)FrameFormat::BGR ? 3 : 1);
+    uint64_t stride = frame.stride != 0 ? frame.stride : rowBytes;
+    if (stride < rowBytes) {
+        return 0;
+    }
+    return stride * (frame.height - 1) + rowBytes;
+}
+
+FrameRing::~FrameRing() {
+    close();
+}
+
+bool FrameRing::create(const std::string& name, uint32_t slotCount, uint32_t slotBytes) {
+    close();
+    slotBytes = (uint32_t)alignUp(slotBytes + FRAME_DATA_OFFSET, 64);
+    size_t total = RING_HEADER_BYTES + (size_t)slotCount * slotBytes;
+
+    ::shm_unlink(name.c_str());
+    fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ::ftruncate(fd, (off_t)total) != 0) {
+        std::cerr << "Could not create shared memory " << name << std::endl;
+        close();
+        return false;
+    }
+    void* memory = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Could not map shared memory " << name << std::endl;
+        close();
+        return false;
+    }
+
+    mapped = static_cast<uchar*>(memory);
+    mappedBytes = total;
+    this->slotCount = slotCount;
+    this->slotBytes = slotBytes;
+    owner = true;
+    shmName = name;
+
+    header = new (mapped) FrameRingHeader();
+    header->slotCount = slotCount;
+    header->slotBytes = slotBytes;
+    header->version = FRAME_RING_VERSION;
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    header->readIndex.store(0, std::memory_order_relaxed);
+    //magic ultimul, ca un consumator sa nu vada un header pe jumatate scris
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = FRAME_RING_MAGIC;
+    return true;
+}
+
+bool FrameRing::open(const std::string& name) {
+    close();
+    fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        std::cerr << "Could not open shared memory " << name << std::endl;
+        return false;
+    }
+
+    //intai doar headerul, ca sa aflam dimensiunea totala
+    void* memory = ::mmap(nullptr, RING_HEADER_BYTES, PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        close();
+        return false;
+    }
+    const FrameRingHeader* probe = static_cast<const FrameRingHeader*>(memory);
+    bool valid = probe->magic == FRAME_RING_MAGIC && probe->version == FRAME_RING_VERSION;
+    uint32_t count = probe->slotCount;
+    uint32_t bytes = probe->slotBytes;
+    ::munmap(memory, RING_HEADER_BYTES);
+    //slotCount 0 ar imparti la zero in slot(), iar un slot mai mic decat headerul cadrului nu are date
+    valid = valid && count > 0 && bytes > FRAME_DATA_OFFSET && bytes % 64 == 0;
+    size_t total = RING_HEADER_BYTES + (size_t)count * bytes;
+    if (!valid) {
+        std::cerr << "Shared memory " << name << " is not a frame ring" << std::endl;
+        close();
+        return false;
+    }
+    //maparea dincolo de sfarsitul segmentului ar da SIGBUS la primul acces
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || (size_t)info.st_size < total) {
+        std::cerr << "Shared memory " << name << " is smaller than its header claims" << std::endl;
+        close();
+        return false;
+    }
+
+    memory = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        close();
+        return false;
+    }
+    mapped = static_cast<uchar*>(memory);
+    mappedBytes = total;
+    slotCount = count;
+    slotBytes = bytes;
+    header = reinterpret_cast<FrameRingHeader*>(mapped);
+    owner = false;
+    shmName = name;
+    return true;
+}
+
+void FrameRing::close() {
+    if (mapped != nullptr) {
+        ::munmap(mapped, mappedBytes);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (owner && !shmName.empty()) {
+        ::shm_unlink(shmName.c_str());
+    }
+    header = nullptr;
+    mapped = nullptr;
+    mappedBytes = 0;
+    slotCount = 0;
+    slotBytes = 0;
+    fd = -1;
+    owner = false;
+    shmName.clear();
+}
+
+uchar* FrameRing::slot(uint64_t index) const {
+    return mapped + RING_HEADER_BYTES + (size_t)(index % slotCount) * slotBytes;
+}
+
+uint32_t FrameRing::payloadCapacity() const {
+    return header != nullptr ? slotBytes - (uint32_t)FRAME_DATA_OFFSET : 0;
+}
+
+uint64_t FrameRing::pending() const {
+    if (header == nullptr) {
+        return 0;
+    }
+    return header->writeIndex.load(std::memory_order_acquire) - header->readIndex.load(std::memory_order_acquire);
+}
+
+//SPSC: doar producatorul scrie writeIndex, doar consumatorul scrie readIndex
+uchar* FrameRing::beginWrite(FrameHeader*& frame) {
+    uint64_t write = header->writeIndex.load(std::memory_order_relaxed);
+    uint64_t read = header->readIndex.load(std::memory_order_acquire);
+    if (write - read >= slotCount) {
+        return nullptr;
+    }
+    uchar* base = slot(write);
+    frame = reinterpret_cast<FrameHeader*>(base);
+    return base + FRAME_DATA_OFFSET;
+}
+
+void FrameRing::commitWrite() {
+    header->writeIndex.fetch_add(1, std::memory_order_release);
+}
+
+bool FrameRing::beginRead(const FrameHeader*& frame, const uchar*& data) {
+    while (true) {
+        uint64_t read = header->readIndex.load(std::memory_order_relaxed);
+        uint64_t write = header->writeIndex.load(std::memory_order_acquire);
+        if (read == write) {
+            return false;
+        }
+        const uchar* base = slot(read);
+        frame = reinterpret_cast<const FrameHeader*>(base);
+        data = base + FRAME_DATA_OFFSET;
+        //width 0 e marcajul de sfarsit; altfel cadrul trebuie sa incapa in bytes, iar bytes in slot
+        if (frame->width == 0 ||
+            (frame->bytes <= payloadCapacity() && frameExtent(*frame) != 0 && frameExtent(*frame) <= frame->bytes)) {
+            return true;
+        }
+        std::cerr << "Dropping malformed frame " << frame->frameId << " (" << frame->width << "x" << frame->height
+                  << ", stride " << frame->stride << ", " << frame->bytes << " bytes)" << std::endl;
+        endRead();
+    }
+}
+
+void FrameRing::endRead() {
+    header->readIndex.fetch_add(1, std::memory_order_release);
+}
+
+Mat FrameRing::frameView(const FrameHeader& frame, const uchar* data) {
+    uint64_t extent = frameExtent(frame);
+    if (frame.width == 0 || extent == 0 || extent > frame.bytes) {
+        return Mat();
+    }
+    return LicensePlateDetector::wrapFrame(data, (int)frame.width, (int)frame.height,
+                                           (FrameFormat)frame.format, frame.stride);
+}
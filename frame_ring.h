@@ -0,0 +1,81 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//inel de cadre in memorie partajata (shm_open + mmap), un producator si un consumator.
+//producatorul scrie direct in slot si publica writeIndex; consumatorul citeste slotul
+//pe loc (Mat fara copiere) si elibereaza slotul avansand readIndex.
+
+const uint32_t FRAME_RING_MAGIC = 0x4C505246; // "LPRF"
+const uint32_t FRAME_RING_VERSION = 2;
+
+struct FrameRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotBytes; //dimensiunea unui slot, inclusiv FrameHeader
+    alignas(64) std::atomic<uint64_t> writeIndex; //urmatorul slot de scris
+    alignas(64) std::atomic<uint64_t> readIndex; //urmatorul slot de citit
+};
+
+//metadatele unui cadru, la inceputul fiecarui slot
+struct FrameHeader {
+    uint64_t frameId;
+    int64_t captureNs; //steady_clock (CLOCK_MONOTONIC, comun proceselor de pe masina): varsta si latenta
+    int64_t timestampNs; //nanosecunde de la epoca Unix (system_clock), doar pentru jurnale si arhiva
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride; //octeti pe rand al planului Y / BGR
+    uint32_t format; //FrameFormat
+    uint32_t bytes; //octeti valizi dupa header
+    uint32_t reserved;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "frame ring needs lock-free 64-bit atomics");
+
+class FrameRing {
+public:
+    FrameRing() : header(nullptr), mapped(nullptr), mappedBytes(0), slotCount(0), slotBytes(0), fd(-1), owner(false) {}
+    ~FrameRing();
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    //producatorul creeaza segmentul, consumatorul il deschide
+    bool create(const std::string& name, uint32_t slotCount, uint32_t slotBytes);
+    bool open(const std::string& name);
+    void close();
+
+    //nullptr daca inelul e plin; dupa scriere, commitWrite() publica slotul
+    uchar* beginWrite(FrameHeader*& frame);
+    void commitWrite();
+
+    //false daca nu e niciun cadru; datele raman valide pana la endRead().
+    //cadrele cu dimensiuni care nu incap in slot sunt eliberate si sarite
+    bool beginRead(const FrameHeader*& frame, const uchar*& data);
+    void endRead();
+
+    //cadrul din slot ca Mat, fara copiere (plan Y pentru YUV); Mat gol daca headerul
+    //descrie mai multi octeti decat frame.bytes
+    static Mat frameView(const FrameHeader& frame, const uchar* data);
+
+    uint32_t payloadCapacity() const;
+    uint64_t pending() const;
+
+private:
+    uchar* slot(uint64_t index) const;
+
+    FrameRingHeader* header;
+    uchar* mapped;
+    size_t mappedBytes;
+    uint32_t slotCount; //copiate la create/open, nu recitite din memoria partajata
+    uint32_t slotBytes;
+    int fd;
+    bool owner;
+    std::string shmName;
+};
+
+#endif
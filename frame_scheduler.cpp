@@ -0,0 +1,105 @@
+#include "frame_scheduler.h"
+#include "metrics.h"
+#include "tracer.h"
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+const char* decisionName(FrameDecision decision) {
+    static const char* names[] = {"full", "reduced_scale", "tracked_roi", "skip"};
+    return names[(int)decision];
+}
+
+FrameScheduler::FrameScheduler(LicensePlateDetector& _detector, const SchedulerConfig& _config)
+    : detector(_detector), config(_config), costMs{0.0, 0.0, 0.0}, framesSinceFullScan(0) {
+}
+
+//parametrii pentru un cadru redus de doua ori mai mult decat normal: dimensiunile liniare
+//se injumatatesc (elementele raman impare), ariile se impart la 4
+static DetectorParams reducedParams(const DetectorParams& full, int frameWidth, int fullFactor) {
+    DetectorParams reduced = full;
+    reduced.canonicalWidth = max(1, frameWidth / (2 * fullFactor));
+    reduced.minPlateArea = full.minPlateArea / 4;
+    reduced.maxPlateArea = full.maxPlateArea / 4;
+    reduced.minContourPixels = full.minContourPixels / 4;
+    reduced.morphWidth = (full.morphWidth / 2) | 1;
+    reduced.morphHeight = (full.morphHeight / 2) | 1;
+    reduced.blurKernelSize = (full.blurKernelSize / 2) | 1;
+    return reduced;
+}
+
+bool FrameScheduler::trackingAvailable() const {
+    return !tracked.empty() && framesSinceFullScan < config.trackedRefreshFrames;
+}
+
+FrameDecision FrameScheduler::decide(double ageMs, size_t backlog) const {
+    //slack-ul se imparte cu cadrele din spate: daca le consumam tot, ratam deadline-ul lor
+    double budgetMs = (config.deadlineMs - ageMs) / (double)(backlog + 1);
+    if (budgetMs <= 0) {
+        return FrameDecision::SKIP;
+    }
+    if (costMs[(int)FrameDecision::FULL] <= budgetMs) {
+        return FrameDecision::FULL;
+    }
+    if (costMs[(int)FrameDecision::REDUCED_SCALE] <= budgetMs) {
+        return FrameDecision::REDUCED_SCALE;
+    }
+    if (trackingAvailable() && costMs[(int)FrameDecision::TRACKED_ROI] <= budgetMs) {
+        return FrameDecision::TRACKED_ROI;
+    }
+    return FrameDecision::SKIP;
+}
+
+//ROI-urile urmarite sunt placutele gasite, extinse cu o margine pentru miscarea dintre cadre
+void FrameScheduler::updateTracked(const vector<PlateCandidate>& plates, Size frameSize) {
+    tracked.clear();
+    Rect frame(0, 0, frameSize.width, frameSize.height);
+    for (const auto& plate : plates) {
+        int marginX = (int)(plate.rect.width * config.trackedMargin);
+        int marginY = (int)(plate.rect.height * config.trackedMargin);
+        Rect r(plate.rect.x - marginX, plate.rect.y - marginY,
+               plate.rect.width + 2 * marginX, plate.rect.height + 2 * marginY);
+        r &= frame;
+        if (!r.empty()) {
+            tracked.push_back(r);
+        }
+    }
+}
+
+vector<PlateCandidate> FrameScheduler::process(const Mat& frame, double ageMs, size_t backlog, FrameDecision& decision) {
+    decision = decide(ageMs, backlog);
+    Metrics::increment((MetricCounter)(COUNTER_DECISION_FULL + (int)decision));
+    if (decision == FrameDecision::SKIP) {
+        return {};
+    }
+
+    TraceSpan span(decisionName(decision));
+    Clock::time_point start = Clock::now();
+    vector<PlateCandidate> plates;
+    if (decision == FrameDecision::TRACKED_ROI) {
+        detector.setRegionOfInterest(tracked);
+        plates = detector.detectLicensePlates(frame, config.maxPlates);
+        detector.clearRegionOfInterest();
+        framesSinceFullScan++;
+    } else {
+        //recititi la fiecare cadru: un setParams facut intre cadre de apelant ramane in vigoare
+        DetectorParams fullParams = detector.getParams();
+        if (decision == FrameDecision::REDUCED_SCALE) {
+            detector.setParams(reducedParams(fullParams, frame.cols, detector.normalizationFactor(frame.cols)));
+        }
+        plates = detector.detectLicensePlates(frame, config.maxPlates);
+        detector.setParams(fullParams);
+        framesSinceFullScan = 0;
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    double& cost = costMs[(int)decision];
+    cost = cost == 0.0 ? elapsedMs : cost + config.costSmoothing * (elapsedMs - cost);
+    if (ageMs + elapsedMs > config.deadlineMs) {
+        Metrics::increment(COUNTER_DEADLINE_MISSES);
+    }
+
+    //o placuta pierduta in ROI-ul urmarit nu mai e urmarita; doar o scanare completa gaseste altele noi
+    updateTracked(plates, frame.size());
+    return plates;
+}
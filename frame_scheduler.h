@@ -0,0 +1,53 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include <vector>
+using namespace std;
+using namespace cv;
+
+//calitatea cu care e procesat un cadru, de la cea mai buna la cea mai ieftina
+enum class FrameDecision {
+    FULL,          //tot cadrul, parametrii normali
+    REDUCED_SCALE, //tot cadrul, la jumatate din latimea canonica
+    TRACKED_ROI,   //doar in jurul placutelor gasite recent
+    SKIP           //cadrul e aruncat
+};
+
+const char* decisionName(FrameDecision decision);
+
+struct SchedulerConfig {
+    double deadlineMs = 100.0; //de la timestamp-ul de captura pana la rezultat
+    int maxPlates = 3;
+    int trackedRefreshFrames = 15; //dupa atatea cadre fara o scanare completa, ROI-urile urmarite expira
+    double trackedMargin = 0.5; //ROI-ul urmarit = placuta extinsa cu atat din latime/inaltime pe fiecare parte
+    double costSmoothing = 0.2; //ponderea ultimei masuratori in media exponentiala a costului
+};
+
+//planificator pentru fluxuri: fiecare cadru are un deadline. Slack-ul ramas se imparte intre
+//cadrul curent si cele care asteapta in spatele lui; se alege cea mai buna calitate al carei
+//cost estimat incape in bugetul asta, altfel cadrul e sarit (oricum ar rata deadline-ul si
+//le-ar intarzia si pe celelalte). Costul fiecarui nivel e invatat din masuratori.
+class FrameScheduler {
+public:
+    FrameScheduler(LicensePlateDetector& detector, const SchedulerConfig& config);
+
+    FrameDecision decide(double ageMs, size_t backlog) const;
+    //ageMs: cat a trecut de la captura; backlog: cadre care asteapta dupa acesta
+    vector<PlateCandidate> process(const Mat& frame, double ageMs, size_t backlog, FrameDecision& decision);
+
+    double estimatedCostMs(FrameDecision decision) const { return costMs[(int)decision]; }
+
+private:
+    bool trackingAvailable() const;
+    void updateTracked(const vector<PlateCandidate>& plates, Size frameSize);
+
+    LicensePlateDetector& detector;
+    SchedulerConfig config;
+
+    double costMs[3]; //FULL, REDUCED_SCALE, TRACKED_ROI; 0 pana la prima masuratoare
+    vector<Rect> tracked;
+    int framesSinceFullScan;
+};
+
+#endif
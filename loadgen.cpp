@@ -0,0 +1,139 @@
+#include <iostream>
+#include "server_protocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using Clock = std::chrono::steady_clock;
+
+//client de incarcare: fiecare conexiune trimite cereri una dupa alta (closed loop)
+//si masuram latenta capat-la-capat a fiecarei cereri
+struct LoadConfig {
+    std::string socketPath = "/tmp/lpr_detector.sock";
+    std::string imagePath;
+    int clients = 8;
+    int requestsPerClient = 100;
+    uint32_t maxPlates = 3;
+};
+
+struct ClientResult {
+    std::vector<double> latenciesMs;
+    int overloaded = 0;
+    int failed = 0;
+};
+
+static int connectTo(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    if (::connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void runClient(const LoadConfig& config, const std::vector<char>& image, int clientId, ClientResult& result) {
+    int fd = connectTo(config.socketPath);
+    if (fd < 0) {
+        result.failed = config.requestsPerClient;
+        return;
+    }
+
+    std::vector<char> body;
+    for (int i = 0; i < config.requestsPerClient; i++) {
+        RequestHeader request = {REQUEST_MAGIC, (uint32_t)(clientId * config.requestsPerClient + i),
+                                 config.maxPlates, (uint32_t)image.size()};
+        Clock::time_point sent = Clock::now();
+        ResponseHeader response;
+        if (!writeAll(fd, &request, sizeof(request)) || !writeAll(fd, image.data(), image.size()) ||
+            !readAll(fd, &response, sizeof(response)) || response.magic != RESPONSE_MAGIC) {
+            result.failed += config.requestsPerClient - i;
+            break;
+        }
+        body.resize(response.length);
+        if (!readAll(fd, body.data(), body.size())) {
+            result.failed += config.requestsPerClient - i;
+            break;
+        }
+
+        if (response.status == STATUS_OK) {
+            result.latenciesMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - sent).count());
+        } else if (response.status == STATUS_OVERLOADED) {
+            result.overloaded++;
+        } else {
+            result.failed++;
+        }
+    }
+    ::close(fd);
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--socket") config.socketPath = value;
+        else if (key == "--image") config.imagePath = value;
+        else if (key == "--clients") config.clients = std::stoi(value);
+        else if (key == "--requests") config.requestsPerClient = std::stoi(value);
+        else if (key == "--max-plates") config.maxPlates = (uint32_t)std::stoul(value);
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+
+    std::ifstream file(config.imagePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Usage: detector_loadgen --image <file.jpg> [--socket path] [--clients n] [--requests n]" << std::endl;
+        return -1;
+    }
+    std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<ClientResult> results(config.clients);
+    std::vector<std::thread> clients;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < config.clients; i++) {
+        clients.emplace_back(runClient, std::cref(config), std::cref(image), i, std::ref(results[i]));
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    int overloaded = 0;
+    int failed = 0;
+    for (const auto& result : results) {
+        latencies.insert(latencies.end(), result.latenciesMs.begin(), result.latenciesMs.end());
+        overloaded += result.overloaded;
+        failed += result.failed;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "Completed:  " << latencies.size() << " in " << seconds << " s" << std::endl;
+    std::cout << "Throughput: " << latencies.size() / seconds << " req/s" << std::endl;
+    std::cout << "Overloaded: " << overloaded << ", failed: " << failed << std::endl;
+    std::cout << "Latency ms: p50=" << percentile(latencies, 0.50) << " p90=" << percentile(latencies, 0.90)
+              << " p99=" << percentile(latencies, 0.99) << " p99.9=" << percentile(latencies, 0.999)
+              << " max=" << (latencies.empty() ? 0.0 : latencies.back()) << std::endl;
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include "proj.h"
+#include "ocr.h"
+#include "async_writer.h"
+#include <chrono>
 using namespace std;
 using namespace cv;
 
@@ -47,8 +50,15 @@ int main() {
     imshow("Original Image", source);
 
     LicensePlateDetector detector;
-    Mat gray = detector.manualGrayscaleConversion(source);
-    Mat blurred = detector.manualGaussianBlur(gray, 5);
+    const DetectorParams& params = detector.getParams();
+    //placuta e in partea de jos a cadrului (y > 40%), procesam doar acolo
+    int roiTop = (int)(source.rows * params.roiTopFraction);
+    detector.setRegionOfInterest(vector<Rect>{Rect(0, roiTop, source.cols, source.rows - roiTop)});
+    Rect crop = detector.regionOfInterestCrop(source.size());
+    Mat view = source(crop);
+
+    Mat gray = detector.manualGrayscaleConversion(view);
+    Mat blurred = detector.manualGaussianBlur(gray, params.blurKernelSize);
     Mat edges = detector.manualSobelOperator(blurred);
     Mat binary = detector.manualThreshold(edges, 0); // Otsu method
     Mat morphed = detector.manualMorphologicalOperation(binary);
@@ -59,15 +69,17 @@ int main() {
     imshow("Morphed", morphed);
 
 
-    Mat morphedCopy = morphed.clone();
-    vector<vector<Point>> morphedContours;
-    findContours(morphedCopy, morphedContours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+    //doar contururile exterioare de pe primul nivel (ca RETR_EXTERNAL)
+    vector<ChainContour> morphedContours = detector.manualTraceContours(morphed);
     int maxArea = 0;
     Rect plateRect;
     for (const auto& c : morphedContours) {
-        Rect r = boundingRect(c);
+        if (c.isHole || c.parent >= 0) {
+            continue;
+        }
+        Rect r(c.bounds.x, c.bounds.y, c.bounds.width, c.bounds.height);
         
-        if (r.area() > maxArea && r.width > r.height * 2.5 && r.y > morphed.rows * 0.4) {
+        if (r.area() > maxArea && r.width > r.height * params.selectionAspectMin && r.y + crop.y > roiTop) {
             maxArea = r.area();
             plateRect = r;
         }
@@ -75,17 +87,48 @@ int main() {
     if (maxArea > 0) {
 
         Mat binaryROI = binary(plateRect);
-        vector<vector<Point>> contours = detector.manualFindContours(binaryROI);
+        //scor din imagini integrale, fara sa mai rulam BFS pe ROI
+        CandidateScorer scorer;
+        scorer.build(edges, binary);
+        MyRect plate(plateRect.x, plateRect.y, plateRect.width, plateRect.height);
+        Rect frameRect(plateRect.x + crop.x, plateRect.y + crop.y, plateRect.width, plateRect.height);
+        double transitions = scorer.transitionsPerRow(plate);
 
         Mat result = source.clone();
-        rectangle(result, plateRect, Scalar(0,255,0), 2);
+        rectangle(result, frameRect, Scalar(0,255,0), 2);
         imshow("Detected Plate (contour)", result);
-        imshow("Plate ROI (contour)", source(plateRect));
+        imshow("Plate ROI (contour)", source(frameRect));
         imshow("Binary Plate ROI (contour)", binaryROI);
         imshow("Morphed Plate ROI (contour)", morphed(plateRect));
-        imwrite("detected_plate_contour.jpg", source(plateRect));
-        cout << "Contours in binary ROI: " << contours.size() << endl;
-        if (contours.size() >= 3) {
+        //placuta indreptata si binarizata adaptiv, apoi segmentata in caractere
+        Mat rectified = detector.rectifyPlate(source, MyRect(frameRect.x, frameRect.y, frameRect.width, frameRect.height));
+        vector<MyRect> characters;
+        if (!rectified.empty()) {
+            Mat rectifiedBinary = detector.preprocessPlate(rectified);
+            characters = detector.segmentCharacters(rectifiedBinary);
+            PlateOcr ocr;
+            PlateReading reading = ocr.read(rectifiedBinary, characters);
+            cout << "Plate text: " << reading.text << " (confidence " << reading.confidence() << ")" << endl;
+            for (const auto& c : reading.characters) {
+                cout << "  " << c.value << " distance " << c.distance << ", confidence " << c.confidence << endl;
+            }
+            Mat segmented;
+            cvtColor(rectified, segmented, COLOR_GRAY2BGR);
+            for (const auto& c : characters) {
+                rectangle(segmented, Rect(c.x, c.y, c.width, c.height), Scalar(0, 0, 255), 1);
+            }
+            imshow("Rectified Plate", segmented);
+            imshow("Rectified Plate Binary", rectifiedBinary);
+        }
+        //decupajul e adaugat in arhiva (crops/) de writer-ul asincron, nu scris ca JPEG separat
+        AsyncWriter writer{AsyncWriterConfig()};
+        int64_t timestamp = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+        writer.submitCrop(0, timestamp, MyRect(frameRect.x, frameRect.y, frameRect.width, frameRect.height),
+                          source(frameRect));
+        cout << "Plate score: " << scorer.score(plate) << ", transitions per row: " << transitions
+             << ", characters: " << characters.size() << endl;
+        if (characters.size() >= 3) {
             cout << "Zona crop-uita are cel putin 3 caractere, este placuta!" << endl;
         } else {
             cout << "Zona crop-uita NU are suficiente caractere!" << endl;
@@ -0,0 +1,305 @@
+#include "metrics.h"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+static const double latencyBounds[LATENCY_BUCKETS] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5
+};
+static const size_t candidateBounds[CANDIDATE_BUCKETS] = {0, 1, 2, 4, 8, 16};
+
+//blocurile thread-urilor nu se elibereaza niciodata: valorile raman valabile
+//si dupa ce thread-ul s-a terminat, iar scrape-ul nu se poate intersecta cu un delete
+static std::mutex registryMutex;
+static std::vector<ThreadMetrics*> registry;
+static std::atomic<bool> metricsEnabled{true};
+
+const char* stageName(PipelineStage stage) {
+    static const char* names[STAGE_COUNT] = {
+        "motion_gate", "quality_gate", "resize", "grayscale", "blur", "sobel", "threshold", "tile_cascade", "morphology", "contours", "selection",
+        "segmentation", "ocr"
+    };
+    return names[stage];
+}
+
+ThreadMetrics& Metrics::local() {
+    thread_local ThreadMetrics* metrics = nullptr;
+    if (metrics == nullptr) {
+        metrics = new ThreadMetrics();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(metrics);
+    }
+    return *metrics;
+}
+
+//un singur scriitor per bloc -> load + store relaxed, fara instructiuni lock
+static inline void bump(std::atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void Metrics::increment(MetricCounter counter, uint64_t value) {
+    if (!enabled()) {
+        return;
+    }
+    bump(local().counters[counter], value);
+}
+
+void Metrics::observeStage(PipelineStage stage, uint64_t nanos) {
+    if (!enabled()) {
+        return;
+    }
+    ThreadMetrics& metrics = local();
+    double seconds = nanos / 1e9;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS && seconds > latencyBounds[bucket]) {
+        bucket++;
+    }
+    bump(metrics.stageBuckets[stage][bucket], 1);
+    bump(metrics.stageNanos[stage], nanos);
+}
+
+void Metrics::stageTotals(uint64_t nanos[STAGE_COUNT]) {
+    ThreadMetrics& metrics = local();
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        nanos[s] = metrics.stageNanos[s].load(std::memory_order_relaxed);
+    }
+}
+
+void Metrics::observeCandidates(size_t count) {
+    if (!enabled()) {
+        return;
+    }
+    ThreadMetrics& metrics = local();
+    int bucket = 0;
+    while (bucket < CANDIDATE_BUCKETS && count > candidateBounds[bucket]) {
+        bucket++;
+    }
+    bump(metrics.candidateBuckets[bucket], 1);
+    bump(metrics.counters[COUNTER_CANDIDATES], count);
+}
+
+void Metrics::setEnabled(bool enabled) {
+    metricsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Metrics::enabled() {
+    return metricsEnabled.load(std::memory_order_relaxed);
+}
+
+static void writeCounter(std::ostringstream& out, const char* name, const char* help, uint64_t value) {
+    out << "# HELP " << name << " " << help << "\n";
+    out << "# TYPE " << name << " counter\n";
+    out << name << " " << value << "\n";
+}
+
+std::string Metrics::renderPrometheus() {
+    uint64_t counters[COUNTER_COUNT] = {};
+    uint64_t stageBuckets[STAGE_COUNT][LATENCY_BUCKETS + 1] = {};
+    uint64_t stageNanos[STAGE_COUNT] = {};
+    uint64_t candidateBuckets[CANDIDATE_BUCKETS + 1] = {};
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const ThreadMetrics* metrics : registry) {
+            for (int c = 0; c < COUNTER_COUNT; c++) {
+                counters[c] += metrics->counters[c].load(std::memory_order_relaxed);
+            }
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                for (int b = 0; b <= LATENCY_BUCKETS; b++) {
+                    stageBuckets[s][b] += metrics->stageBuckets[s][b].load(std::memory_order_relaxed);
+                }
+                stageNanos[s] += metrics->stageNanos[s].load(std::memory_order_relaxed);
+            }
+            for (int b = 0; b <= CANDIDATE_BUCKETS; b++) {
+                candidateBuckets[b] += metrics->candidateBuckets[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ostringstream out;
+    writeCounter(out, "lpr_frames_processed_total", "Frames run through the detector.", counters[COUNTER_FRAMES_PROCESSED]);
+    writeCounter(out, "lpr_plates_found_total", "Plates returned by the detector.", counters[COUNTER_PLATES_FOUND]);
+    writeCounter(out, "lpr_no_plate_frames_total", "Frames in which no plate was found.", counters[COUNTER_NO_PLATE_FRAMES]);
+    writeCounter(out, "lpr_candidates_total", "Candidates that passed findPossiblePlateRegions.", counters[COUNTER_CANDIDATES]);
+    writeCounter(out, "lpr_motion_idle_frames_total", "Frames without motion that skipped detection.", counters[COUNTER_MOTION_IDLE_FRAMES]);
+    writeCounter(out, "lpr_quality_rejected_frames_total", "Frames below the sharpness/exposure thresholds.", counters[COUNTER_QUALITY_REJECTED_FRAMES]);
+    writeCounter(out, "lpr_deadline_misses_total", "Scheduled frames that finished after their deadline.", counters[COUNTER_DEADLINE_MISSES]);
+    writeCounter(out, "lpr_ocr_calls_total", "OCR runs made by the per-track consensus.", counters[COUNTER_OCR_CALLS]);
+    writeCounter(out, "lpr_plate_events_total", "Per-vehicle plate events emitted when a track closed.", counters[COUNTER_PLATE_EVENTS]);
+    writeCounter(out, "lpr_writer_dropped_total", "Output items dropped because the async writer queue was full.", counters[COUNTER_WRITER_DROPPED]);
+
+    static const char* decisionNames[] = {"full", "reduced_scale", "tracked_roi", "skip"};
+    out << "# HELP lpr_scheduler_decisions_total Frames per quality level chosen by the deadline scheduler.\n";
+    out << "# TYPE lpr_scheduler_decisions_total counter\n";
+    for (int d = 0; d < 4; d++) {
+        out << "lpr_scheduler_decisions_total{decision=\"" << decisionNames[d] << "\"} "
+            << counters[COUNTER_DECISION_FULL + d] << "\n";
+    }
+
+    out << "# HELP lpr_stage_duration_seconds Time spent in each detector stage.\n";
+    out << "# TYPE lpr_stage_duration_seconds histogram\n";
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        const char* name = stageName((PipelineStage)s);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            cumulative += stageBuckets[s][b];
+            out << "lpr_stage_duration_seconds_bucket{stage=\"" << name << "\",le=\"" << latencyBounds[b] << "\"} " << cumulative << "\n";
+        }
+        cumulative += stageBuckets[s][LATENCY_BUCKETS];
+        out << "lpr_stage_duration_seconds_bucket{stage=\"" << name << "\",le=\"+Inf\"} " << cumulative << "\n";
+        out << "lpr_stage_duration_seconds_sum{stage=\"" << name << "\"} " << stageNanos[s] / 1e9 << "\n";
+        out << "lpr_stage_duration_seconds_count{stage=\"" << name << "\"} " << cumulative << "\n";
+    }
+
+    out << "# HELP lpr_candidates_per_frame Candidates per frame from findPossiblePlateRegions.\n";
+    out << "# TYPE lpr_candidates_per_frame histogram\n";
+    uint64_t cumulative = 0;
+    for (int b = 0; b < CANDIDATE_BUCKETS; b++) {
+        cumulative += candidateBuckets[b];
+        out << "lpr_candidates_per_frame_bucket{le=\"" << candidateBounds[b] << "\"} " << cumulative << "\n";
+    }
+    cumulative += candidateBuckets[CANDIDATE_BUCKETS];
+    out << "lpr_candidates_per_frame_bucket{le=\"+Inf\"} " << cumulative << "\n";
+    out << "lpr_candidates_per_frame_sum " << counters[COUNTER_CANDIDATES] << "\n";
+    out << "lpr_candidates_per_frame_count " << cumulative << "\n";
+
+    return out.str();
+}
+
+bool Metrics::writeTextfile(const std::string& path) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file << renderPrometheus();
+        if (!file.good()) {
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+void MetricsExporter::startTextfile(const std::string& path, int periodSeconds) {
+    running = true;
+    textfileThread = std::thread([this, path, periodSeconds] {
+        while (running) {
+            Metrics::writeTextfile(path);
+            for (int i = 0; i < periodSeconds * 10 && running; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+    });
+}
+
+#ifndef _WIN32
+bool MetricsExporter::startHttp(int port) {
+    listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(listenFd, 16) < 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    running = true;
+    httpThread = std::thread(&MetricsExporter::serveHttp, this);
+    return true;
+}
+
+//server HTTP minimal: o cerere pe conexiune, raspuns si inchidere
+void MetricsExporter::serveHttp() {
+    while (running) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!running) {
+                break; //stop() a inchis socket-ul
+            }
+            //EMFILE/ENFILE si altele: fara pauza bucla ar ocupa un nucleu pana se elibereaza descriptori
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        //un client care nu trimite cererea (sau nu citeste raspunsul) ar bloca singurul thread HTTP
+        timeval timeout = {2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        ssize_t n = ::read(fd, request, sizeof(request) - 1);
+        request[n > 0 ? n : 0] = '\0';
+
+        std::string response;
+        if (std::string(request).rfind("GET /metrics", 0) == 0) {
+            std::string body = Metrics::renderPrometheus();
+            response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                       std::to_string(body.size()) + "\r\n\r\n" + body;
+        } else {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        }
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t written = ::write(fd, response.data() + sent, response.size() - sent);
+            if (written <= 0) {
+                break;
+            }
+            sent += (size_t)written;
+        }
+        ::close(fd);
+    }
+}
+
+void MetricsExporter::stop() {
+    running = false;
+    if (listenFd >= 0) {
+        ::shutdown(listenFd, SHUT_RDWR); //deblocheaza accept()
+        ::close(listenFd);
+        listenFd = -1;
+    }
+    if (httpThread.joinable()) {
+        httpThread.join();
+    }
+    if (textfileThread.joinable()) {
+        textfileThread.join();
+    }
+}
+#else
+bool MetricsExporter::startHttp(int port) {
+    return false; //pe Windows doar exportul in fisier
+}
+
+void MetricsExporter::serveHttp() {
+}
+
+void MetricsExporter::stop() {
+    running = false;
+    if (textfileThread.joinable()) {
+        textfileThread.join();
+    }
+}
+#endif
@@ -0,0 +1,120 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "tracer.h"
+
+//metrici de runtime in format Prometheus.
+//fiecare thread scrie doar in propriul bloc (atomics relaxed, un singur scriitor),
+//iar agregarea peste toate thread-urile se face abia la scrape.
+
+enum MetricCounter {
+    COUNTER_FRAMES_PROCESSED,
+    COUNTER_PLATES_FOUND,
+    COUNTER_NO_PLATE_FRAMES,
+    COUNTER_CANDIDATES,
+    //deciziile FrameScheduler, in ordinea FrameDecision
+    COUNTER_DECISION_FULL,
+    COUNTER_DECISION_REDUCED_SCALE,
+    COUNTER_DECISION_TRACKED_ROI,
+    COUNTER_DECISION_SKIP,
+    COUNTER_DEADLINE_MISSES,
+    COUNTER_MOTION_IDLE_FRAMES,
+    COUNTER_QUALITY_REJECTED_FRAMES,
+    COUNTER_OCR_CALLS,
+    COUNTER_PLATE_EVENTS,
+    COUNTER_WRITER_DROPPED,
+    COUNTER_COUNT
+};
+
+//etapele lui detectLicensePlate, in ordinea din pipeline
+enum PipelineStage {
+    STAGE_MOTION_GATE,
+    STAGE_QUALITY_GATE,
+    STAGE_RESIZE,
+    STAGE_GRAYSCALE,
+    STAGE_BLUR,
+    STAGE_SOBEL,
+    STAGE_THRESHOLD,
+    STAGE_TILE_CASCADE,
+    STAGE_MORPHOLOGY,
+    STAGE_CONTOURS,
+    STAGE_SELECTION,
+    STAGE_SEGMENTATION, //segmentCharacters, pe placuta deja decupata
+    STAGE_OCR,
+    STAGE_COUNT
+};
+
+const char* stageName(PipelineStage stage);
+
+const int LATENCY_BUCKETS = 12; //limite in secunde, vezi latencyBounds
+const int CANDIDATE_BUCKETS = 6;
+
+struct ThreadMetrics {
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    //histograme ne-cumulative; ultimul bucket e +Inf
+    std::array<std::array<std::atomic<uint64_t>, LATENCY_BUCKETS + 1>, STAGE_COUNT> stageBuckets{};
+    std::array<std::atomic<uint64_t>, STAGE_COUNT> stageNanos{};
+    std::array<std::atomic<uint64_t>, CANDIDATE_BUCKETS + 1> candidateBuckets{};
+};
+
+class Metrics {
+public:
+    static void increment(MetricCounter counter, uint64_t value = 1);
+    static void observeStage(PipelineStage stage, uint64_t nanos);
+    static void observeCandidates(size_t count);
+    //timpul cumulat pe etape al thread-ului curent; diferenta intre doua apeluri = timpii unui cadru
+    static void stageTotals(uint64_t nanos[STAGE_COUNT]);
+
+    //textul complet pentru /metrics (agregat peste toate thread-urile)
+    static std::string renderPrometheus();
+    //scrie atomic (fisier temporar + rename), pentru textfile collector din node_exporter
+    static bool writeTextfile(const std::string& path);
+
+    static void setEnabled(bool enabled);
+    static bool enabled();
+
+private:
+    static ThreadMetrics& local();
+};
+
+//masoara o etapa si o inregistreaza la iesirea din scope (histograma + span in trace)
+class StageTimer {
+public:
+    explicit StageTimer(PipelineStage _stage)
+        : stage(_stage), span(stageName(_stage)), start(std::chrono::steady_clock::now()) {}
+    ~StageTimer() {
+        Metrics::observeStage(stage, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    PipelineStage stage;
+    TraceSpan span;
+    std::chrono::steady_clock::time_point start;
+};
+
+//exportator in fundal: endpoint HTTP pe localhost si/sau fisier rescris periodic
+class MetricsExporter {
+public:
+    MetricsExporter() : running(false), listenFd(-1) {}
+    ~MetricsExporter();
+
+    bool startHttp(int port); //GET /metrics pe 127.0.0.1:port
+    void startTextfile(const std::string& path, int periodSeconds);
+    void stop();
+
+private:
+    void serveHttp();
+
+    std::atomic<bool> running;
+    int listenFd;
+    std::thread httpThread;
+    std::thread textfileThread;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "motion_gate.h"
+#include "proj.h"
+#include "metrics.h"
+#include "simd.h"
+#include <queue>
+
+MotionGate::MotionGate() : MotionGate(MotionGateConfig()) {
+}
+
+MotionGate::MotionGate(const MotionGateConfig& _config) : config(_config) {
+}
+
+void MotionGate::reset() {
+    background = Mat();
+    background8 = Mat();
+    tiles = Mat();
+    regions.clear();
+}
+
+//|a - b| pe octeti: doua scaderi cu saturare si sau logic (SSE2), vabdq pe NEON
+static void absDiffRow(const uchar* a, const uchar* b, uchar* diff, int n) {
+    int j = 0;
+#if defined(LPR_SSE2)
+    for (; j + 16 <= n; j += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + j));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+        _mm_storeu_si128((__m128i*)(diff + j), _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)));
+    }
+#elif defined(LPR_NEON)
+    for (; j + 16 <= n; j += 16) {
+        vst1q_u8(diff + j, vabdq_u8(vld1q_u8(a + j), vld1q_u8(b + j)));
+    }
+#endif
+    for (; j < n; j++) {
+        diff[j] = (uchar)abs((int)a[j] - (int)b[j]);
+    }
+}
+
+bool MotionGate::update(const Mat& frame) {
+    StageTimer timer(STAGE_MOTION_GATE);
+    int factor = max(1, frame.cols / max(1, config.analysisWidth));
+    Mat luma = LicensePlateDetector::decimatedLuma(frame, config.analysisWidth);
+    int tileSize = config.tileSize;
+    int tileRows = (luma.rows + tileSize - 1) / tileSize;
+    int tileCols = (luma.cols + tileSize - 1) / tileSize;
+
+    //primul cadru: fundalul e chiar cadrul, iar detectia ruleaza pe tot cadrul
+    if (background.size() != luma.size()) {
+        background = Mat(luma.size(), CV_16UC1);
+        background8 = luma.clone();
+        for (int i = 0; i < luma.rows; i++) {
+            const uchar* src = luma.ptr<uchar>(i);
+            ushort* bg = background.ptr<ushort>(i);
+            for (int j = 0; j < luma.cols; j++) {
+                bg[j] = (ushort)(src[j] << 8);
+            }
+        }
+        tiles = Mat(tileRows, tileCols, CV_8UC1, Scalar(255));
+        regions.clear();
+        return true;
+    }
+
+    vector<int> changed(tileRows * tileCols, 0);
+    vector<uchar> diff(luma.cols);
+    for (int i = 0; i < luma.rows; i++) {
+        const uchar* cur = luma.ptr<uchar>(i);
+        ushort* bg = background.ptr<ushort>(i);
+        uchar* bg8 = background8.ptr<uchar>(i);
+        absDiffRow(cur, bg8, diff.data(), luma.cols);
+
+        int* tileRow = changed.data() + (i / tileSize) * tileCols;
+        for (int j = 0; j < luma.cols; j++) {
+            tileRow[j / tileSize] += diff[j] > config.pixelThreshold;
+            //fundal mediat exponential; un obiect care se opreste devine treptat fundal
+            int value = bg[j];
+            value += ((cur[j] << 8) - value) >> config.learningShift;
+            bg[j] = (ushort)value;
+            bg8[j] = (uchar)(value >> 8);
+        }
+    }
+
+    tiles = Mat::zeros(tileRows, tileCols, CV_8UC1);
+    for (int ti = 0; ti < tileRows; ti++) {
+        for (int tj = 0; tj < tileCols; tj++) {
+            int h = min(tileSize, luma.rows - ti * tileSize);
+            int w = min(tileSize, luma.cols - tj * tileSize);
+            if (changed[ti * tileCols + tj] >= config.tileChangedFraction * w * h) {
+                tiles.at<uchar>(ti, tj) = 255;
+            }
+        }
+    }
+
+    collectRegions(factor, frame.size());
+    return !regions.empty();
+}
+
+//componentele conexe de tile-uri schimbate, fiecare extinsa cu un tile si dusa in coordonatele cadrului
+void MotionGate::collectRegions(int factor, Size frameSize) {
+    regions.clear();
+    Mat visited = Mat::zeros(tiles.size(), CV_8UC1);
+    Rect frame(0, 0, frameSize.width, frameSize.height);
+    int cell = config.tileSize * factor;
+
+    for (int ti = 0; ti < tiles.rows; ti++) {
+        for (int tj = 0; tj < tiles.cols; tj++) {
+            if (tiles.at<uchar>(ti, tj) == 0 || visited.at<uchar>(ti, tj) > 0) {
+                continue;
+            }
+            int minI = ti, maxI = ti, minJ = tj, maxJ = tj;
+            queue<Point> q;
+            q.push(Point(tj, ti));
+            visited.at<uchar>(ti, tj) = 255;
+            while (!q.empty()) {
+                Point p = q.front();
+                q.pop();
+                minI = min(minI, p.y);
+                maxI = max(maxI, p.y);
+                minJ = min(minJ, p.x);
+                maxJ = max(maxJ, p.x);
+
+                const int dx[] = {-1, 1, 0, 0};
+                const int dy[] = {0, 0, -1, 1};
+                for (int k = 0; k < 4; k++) {
+                    int nx = p.x + dx[k];
+                    int ny = p.y + dy[k];
+                    if (nx >= 0 && nx < tiles.cols && ny >= 0 && ny < tiles.rows &&
+                        tiles.at<uchar>(ny, nx) > 0 && visited.at<uchar>(ny, nx) == 0) {
+                        visited.at<uchar>(ny, nx) = 255;
+                        q.push(Point(nx, ny));
+                    }
+                }
+            }
+
+            Rect r((minJ - 1) * cell, (minI - 1) * cell, (maxJ - minJ + 3) * cell, (maxI - minI + 3) * cell);
+            r &= frame;
+            if (!r.empty()) {
+                regions.push_back(r);
+            }
+        }
+    }
+}
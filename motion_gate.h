@@ -0,0 +1,41 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+#include <opencv2/opencv.hpp>
+#include <vector>
+using namespace std;
+using namespace cv;
+
+struct MotionGateConfig {
+    int analysisWidth = 160; //cadrul e redus (medie pe blocuri) pana la cel putin latimea asta
+    int tileSize = 8; //in pixeli ai cadrului redus
+    int pixelThreshold = 20; //|cadru - fundal| peste care pixelul s-a schimbat
+    double tileChangedFraction = 0.15; //tile-ul e in miscare daca atatia pixeli s-au schimbat
+    int learningShift = 4; //fundalul se apropie de cadru cu 1/2^shift pe cadru
+};
+
+//poarta de miscare: diferenta absoluta (SIMD) intre luminanta redusa si un fundal mediat.
+//Fara miscare, detectia poate fi sarita; cu miscare, regiunile schimbate devin ROI-ul detectorului.
+class MotionGate {
+public:
+    MotionGate();
+    explicit MotionGate(const MotionGateConfig& config);
+
+    //true daca e miscare semnificativa; primul cadru (sau o schimbare de dimensiune) conteaza ca miscare
+    bool update(const Mat& frame);
+    //dreptunghiurile in miscare, in coordonatele cadrului; gol = tot cadrul
+    const vector<Rect>& movingRegions() const { return regions; }
+    //CV_8UC1, 255 = tile schimbat la ultimul update
+    const Mat& changedTiles() const { return tiles; }
+    void reset();
+
+private:
+    void collectRegions(int factor, Size frameSize);
+
+    MotionGateConfig config;
+    Mat background; //CV_16UC1, luminanta * 256 (virgula fixa)
+    Mat background8; //partea intreaga, pentru diferenta pe 8 biti
+    Mat tiles;
+    vector<Rect> regions;
+};
+
+#endif
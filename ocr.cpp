@@ -0,0 +1,139 @@
+#include "ocr.h"
+#include "metrics.h"
+#include <bit>
+
+//sabloanele si litera fiecaruia, in aceeasi ordine
+struct GlyphBank {
+    vector<PackedGlyph> glyphs;
+    vector<char> labels;
+};
+
+int PackedGlyph::distance(const PackedGlyph& other) const {
+    int total = 0;
+    for (int w = 0; w < GLYPH_WORDS; w++) {
+        total += popcount(bits[w] ^ other.bits[w]);
+    }
+    return total;
+}
+
+double PlateReading::confidence() const {
+    if (characters.empty()) {
+        return 0.0;
+    }
+    double lowest = 1.0;
+    for (const auto& c : characters) {
+        lowest = min(lowest, c.confidence);
+    }
+    return lowest;
+}
+
+//fiecare celula primeste bitul majoritar din dreptunghiul sursa corespunzator
+PackedGlyph PlateOcr::normalize(const Mat& binary, const MyRect& box) {
+    PackedGlyph glyph;
+    Rect bounds = Rect(box.x, box.y, box.width, box.height) & Rect(0, 0, binary.cols, binary.rows);
+    if (bounds.width <= 0 || bounds.height <= 0) {
+        return glyph;
+    }
+    int width = min(GLYPH_WIDTH, max(1, (bounds.width * GLYPH_HEIGHT + bounds.height / 2) / bounds.height));
+    int offset = (GLYPH_WIDTH - width) / 2;
+    for (int r = 0; r < GLYPH_HEIGHT; r++) {
+        int y0 = bounds.y + r * bounds.height / GLYPH_HEIGHT;
+        int y1 = max(y0 + 1, bounds.y + (r + 1) * bounds.height / GLYPH_HEIGHT);
+        for (int c = 0; c < width; c++) {
+            int x0 = bounds.x + c * bounds.width / width;
+            int x1 = max(x0 + 1, bounds.x + (c + 1) * bounds.width / width);
+            int ink = 0;
+            for (int y = y0; y < y1; y++) {
+                const uchar* row = binary.ptr<uchar>(y);
+                for (int x = x0; x < x1; x++) {
+                    ink += row[x] != 0;
+                }
+            }
+            if (2 * ink >= (y1 - y0) * (x1 - x0)) {
+                glyph.set(r, offset + c);
+            }
+        }
+    }
+    return glyph;
+}
+
+//randare alb pe negru, apoi acelasi decupaj + normalizare ca pentru caracterele de pe placuta
+static const GlyphBank& defaultBank() {
+    static const GlyphBank bank = [] {
+        GlyphBank built;
+        const string alphabet = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        const int fonts[] = {FONT_HERSHEY_SIMPLEX, FONT_HERSHEY_DUPLEX};
+        const int thicknesses[] = {2, 4};
+        for (char letter : alphabet) {
+            for (int font : fonts) {
+                for (int thickness : thicknesses) {
+                    Mat canvas = Mat::zeros(64, 64, CV_8UC1);
+                    putText(canvas, string(1, letter), Point(12, 52), font, 1.5, Scalar(255), thickness, LINE_8);
+                    int minX = canvas.cols, minY = canvas.rows, maxX = -1, maxY = -1;
+                    for (int i = 0; i < canvas.rows; i++) {
+                        const uchar* row = canvas.ptr<uchar>(i);
+                        for (int j = 0; j < canvas.cols; j++) {
+                            if (row[j] != 0) {
+                                minX = min(minX, j);
+                                maxX = max(maxX, j);
+                                minY = min(minY, i);
+                                maxY = max(maxY, i);
+                            }
+                        }
+                    }
+                    if (maxX < 0) {
+                        continue;
+                    }
+                    MyRect ink(minX, minY, maxX - minX + 1, maxY - minY + 1);
+                    built.glyphs.push_back(PlateOcr::normalize(canvas, ink));
+                    built.labels.push_back(letter);
+                }
+            }
+        }
+        return built;
+    }();
+    return bank;
+}
+
+PlateOcr::PlateOcr() : bank(defaultBank()) {
+}
+
+size_t PlateOcr::glyphCount() const {
+    return bank.glyphs.size();
+}
+
+//cel mai apropiat sablon si cel mai apropiat sablon al unei alte litere (pentru incredere)
+CharacterReading PlateOcr::classify(const PackedGlyph& glyph) const {
+    CharacterReading reading;
+    reading.distance = GLYPH_BITS + 1;
+    vector<int> bestPerLetter(128, GLYPH_BITS + 1);
+    for (size_t g = 0; g < bank.glyphs.size(); g++) {
+        int d = glyph.distance(bank.glyphs[g]);
+        int& best = bestPerLetter[(uchar)bank.labels[g]];
+        best = min(best, d);
+        if (d < reading.distance) {
+            reading.distance = d;
+            reading.value = bank.labels[g];
+        }
+    }
+    int runnerUp = GLYPH_BITS + 1;
+    for (int letter = 0; letter < 128; letter++) {
+        if (letter != (uchar)reading.value) {
+            runnerUp = min(runnerUp, bestPerLetter[letter]);
+        }
+    }
+    reading.confidence = runnerUp > 0 ? max(0.0, 1.0 - (double)reading.distance / runnerUp) : 0.0;
+    return reading;
+}
+
+PlateReading PlateOcr::read(const Mat& binaryPlate, const vector<MyRect>& characters) const {
+    StageTimer timer(STAGE_OCR);
+    PlateReading result;
+    for (const auto& box : characters) {
+        CharacterReading reading = classify(normalize(binaryPlate, box));
+        reading.box = box;
+        result.text += reading.value;
+        result.characters.push_back(reading);
+    }
+    return result;
+}
@@ -0,0 +1,75 @@
+#ifndef OCR_H
+#define OCR_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace cv;
+
+//un caracter normalizat pe grila GLYPH_WIDTH x GLYPH_HEIGHT, un bit pe celula (1 = cerneala),
+//randurile puse unul dupa altul in GLYPH_WORDS cuvinte de 64 de biti
+const int GLYPH_WIDTH = 16;
+const int GLYPH_HEIGHT = 24;
+const int GLYPH_BITS = GLYPH_WIDTH * GLYPH_HEIGHT;
+const int GLYPH_WORDS = GLYPH_BITS / 64;
+
+class PackedGlyph {
+public:
+    uint64_t bits[GLYPH_WORDS];
+
+    PackedGlyph() : bits{} {}
+
+    void set(int row, int col) {
+        int index = row * GLYPH_WIDTH + col;
+        bits[index >> 6] |= 1ull << (index & 63);
+    }
+    //distanta Hamming: XOR + popcount pe cuvinte
+    int distance(const PackedGlyph& other) const;
+};
+
+//rezultatul pentru un caracter: litera aleasa, distanta la cel mai apropiat sablon si increderea
+//(1 - distanta / distanta celui mai bun sablon al altei litere; 0 = ambiguu)
+class CharacterReading {
+public:
+    char value;
+    double confidence;
+    int distance;
+    MyRect box; //in coordonatele placutei binarizate
+
+    CharacterReading() : value('?'), confidence(0.0), distance(GLYPH_BITS) {}
+};
+
+class PlateReading {
+public:
+    string text;
+    vector<CharacterReading> characters;
+
+    //increderea placutei e cea a celui mai nesigur caracter
+    double confidence() const;
+};
+
+//OCR prin potrivire de sabloane: fiecare caracter segmentat e normalizat pe grila binara si
+//comparat cu banca de glife 0-9, A-Z. Banca e generata o singura data pe proces din randari
+//cv::putText (cateva fonturi si grosimi), deci nu are nevoie de fisiere externe.
+struct GlyphBank;
+
+class PlateOcr {
+public:
+    PlateOcr();
+
+    //binaryPlate: iesirea lui preprocessPlate (alb = cerneala); characters: din segmentCharacters
+    PlateReading read(const Mat& binaryPlate, const vector<MyRect>& characters) const;
+    CharacterReading classify(const PackedGlyph& glyph) const;
+
+    //inaltimea caracterului umple grila; latimea pastreaza proportia, centrata (cel mult GLYPH_WIDTH)
+    static PackedGlyph normalize(const Mat& binary, const MyRect& box);
+
+    size_t glyphCount() const;
+
+private:
+    const GlyphBank& bank; //partajata, doar citita dupa constructie
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include "plate_tracker.h"
+#include "metrics.h"
+#include <algorithm>
+#include <tuple>
+
+void TrackVotes::add(const PlateReading& reading) {
+    int length = (int)reading.characters.size();
+    vector<map<char, double>>& positions = votes[length];
+    positions.resize(length);
+    double total = 0.0;
+    for (int i = 0; i < length; i++) {
+        //o citire ambigua (incredere 0) tot numara putin, ca sa nu piara complet
+        double weight = 0.05 + reading.characters[i].confidence;
+        positions[i][reading.characters[i].value] += weight;
+        total += weight;
+    }
+    lengthWeight[length] += total / max(1, length);
+    lengthReadings[length]++;
+}
+
+int TrackVotes::readings(int length) const {
+    auto found = lengthReadings.find(length);
+    return found != lengthReadings.end() ? found->second : 0;
+}
+
+string TrackVotes::consensus(double& confidence) const {
+    confidence = 0.0;
+    int bestLength = -1;
+    double bestWeight = 0.0;
+    for (const auto& entry : lengthWeight) {
+        if (entry.second > bestWeight) {
+            bestWeight = entry.second;
+            bestLength = entry.first;
+        }
+    }
+    if (bestLength <= 0) {
+        return "";
+    }
+
+    string text;
+    double lowest = 1.0;
+    for (const auto& position : votes.at(bestLength)) {
+        char winner = '?';
+        double winnerWeight = 0.0, total = 0.0;
+        for (const auto& vote : position) {
+            total += vote.second;
+            if (vote.second > winnerWeight) {
+                winnerWeight = vote.second;
+                winner = vote.first;
+            }
+        }
+        text += winner;
+        lowest = min(lowest, total > 0 ? winnerWeight / total : 0.0);
+    }
+    confidence = lowest;
+    return text;
+}
+
+PlateTracker::PlateTracker(LicensePlateDetector& _detector, const TrackerConfig& _config)
+    : detector(_detector), config(_config) {
+}
+
+double PlateTracker::focusMeasure(const Mat& frame, const MyRect& box) {
+    Rect bounds = Rect(box.x, box.y, box.width, box.height) & Rect(0, 0, frame.cols, frame.rows);
+    if (bounds.width < 2 || bounds.height < 1) {
+        return 0.0;
+    }
+    int channels = frame.channels();
+    long long sum = 0;
+    long long count = 0;
+    for (int i = bounds.y; i < bounds.y + bounds.height; i += 2) {
+        const uchar* row = frame.ptr<uchar>(i) + bounds.x * channels;
+        int previous = -1;
+        for (int j = 0; j < bounds.width; j++) {
+            const uchar* p = row + j * channels;
+            //0.299/0.587/0.114 in virgula fixa pe 8 biti; un canal = deja luminanta
+            int luma = channels >= 3 ? (29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8 : p[0];
+            if (previous >= 0) {
+                int d = luma - previous;
+                sum += d * d;
+                count++;
+            }
+            previous = luma;
+        }
+    }
+    return count > 0 ? (double)sum / count : 0.0;
+}
+
+//OCR doar daca pista nu a convers, mai are rulari disponibile, a trecut pauza minima
+//si cadrul e aproape la fel de clar ca cel mai clar vazut pana acum
+void PlateTracker::maybeRunOcr(Track& track, const Mat& frame) {
+    if (track.converged || track.ocrRuns >= config.maxOcrRuns) {
+        return;
+    }
+    if (track.ocrRuns > 0 && frameIndex - track.lastOcrFrame < (uint64_t)config.minOcrGapFrames) {
+        return;
+    }
+    double focus = focusMeasure(frame, track.box);
+    track.bestFocus = max(track.bestFocus, focus);
+    if (focus < config.focusRatio * track.bestFocus) {
+        return;
+    }
+
+    track.ocrRuns++;
+    track.lastOcrFrame = frameIndex;
+    totalOcrRuns++;
+    Metrics::increment(COUNTER_OCR_CALLS);
+
+    Mat rectified = detector.rectifyPlate(frame, track.box);
+    if (rectified.empty()) {
+        return;
+    }
+    Mat binary = detector.preprocessPlate(rectified);
+    vector<MyRect> characters = detector.segmentCharacters(binary);
+    if (characters.size() < 3) {
+        return;
+    }
+    track.votes.add(ocr.read(binary, characters));
+
+    //doar citirile de lungimea consensului voteaza pozitiile lui
+    double confidence;
+    string text = track.votes.consensus(confidence);
+    if (track.votes.readings((int)text.size()) >= config.minAgreeingReadings && confidence >= config.convergedShare) {
+        track.converged = true;
+    }
+}
+
+bool PlateTracker::close(Track& track, PlateEvent& event) const {
+    event.trackId = track.id;
+    event.text = track.votes.consensus(event.confidence);
+    event.firstFrame = track.firstFrame;
+    event.lastFrame = track.lastFrame;
+    event.ocrRuns = track.ocrRuns;
+    event.lastBox = track.box;
+    return !event.text.empty();
+}
+
+vector<PlateEvent> PlateTracker::update(const Mat& frame, const vector<PlateCandidate>& plates) {
+    //asociere greedy: perechile (pista, detectie) in ordinea descrescatoare a IoU
+    vector<tuple<double, int, int>> pairs;
+    for (int t = 0; t < (int)tracks.size(); t++) {
+        for (int p = 0; p < (int)plates.size(); p++) {
+            double iou = tracks[t].box.iou(plates[p].rect);
+            if (iou >= config.matchIoU) {
+                pairs.emplace_back(iou, t, p);
+            }
+        }
+    }
+    sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return get<0>(a) > get<0>(b); });
+
+    vector<bool> trackMatched(tracks.size(), false);
+    vector<bool> plateMatched(plates.size(), false);
+    for (const auto& [iou, t, p] : pairs) {
+        if (trackMatched[t] || plateMatched[p]) {
+            continue;
+        }
+        trackMatched[t] = true;
+        plateMatched[p] = true;
+        tracks[t].box = plates[p].rect;
+        tracks[t].lastFrame = frameIndex;
+        tracks[t].missed = 0;
+    }
+    for (size_t t = 0; t < trackMatched.size(); t++) {
+        if (!trackMatched[t]) {
+            tracks[t].missed++;
+        }
+    }
+    for (size_t p = 0; p < plates.size(); p++) {
+        if (!plateMatched[p]) {
+            Track track;
+            track.id = nextId++;
+            track.box = plates[p].rect;
+            track.firstFrame = track.lastFrame = frameIndex;
+            tracks.push_back(track);
+        }
+    }
+
+    vector<PlateEvent> events;
+    for (auto it = tracks.begin(); it != tracks.end();) {
+        if (it->missed > config.maxMissedFrames) {
+            PlateEvent event;
+            if (close(*it, event)) {
+                events.push_back(event);
+                Metrics::increment(COUNTER_PLATE_EVENTS);
+            }
+            it = tracks.erase(it);
+            continue;
+        }
+        if (it->missed == 0) {
+            maybeRunOcr(*it, frame);
+        }
+        ++it;
+    }
+    frameIndex++;
+    return events;
+}
+
+vector<PlateEvent> PlateTracker::flush() {
+    vector<PlateEvent> events;
+    for (auto& track : tracks) {
+        PlateEvent event;
+        if (close(track, event)) {
+            events.push_back(event);
+            Metrics::increment(COUNTER_PLATE_EVENTS);
+        }
+    }
+    tracks.clear();
+    return events;
+}
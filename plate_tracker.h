@@ -0,0 +1,93 @@
+#ifndef PLATE_TRACKER_H
+#define PLATE_TRACKER_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "ocr.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace cv;
+
+struct TrackerConfig {
+    double matchIoU = 0.3; //o detectie continua pista daca se suprapune atat cu ultima ei pozitie
+    int maxMissedFrames = 10; //pista se inchide (si emite evenimentul) dupa atatea cadre fara detectie
+    double focusRatio = 0.85; //OCR doar pe cadrele cel putin atat de clare ca cel mai clar vazut pe pista
+    int minOcrGapFrames = 2; //intre doua rulari OCR pe aceeasi pista
+    int maxOcrRuns = 6;
+    int minAgreeingReadings = 2; //citiri de lungimea castigatoare inainte ca pista sa poata converge
+    double convergedShare = 0.75; //fiecare pozitie are un castigator cu cel putin atata din voturi
+};
+
+//o placuta per vehicul, emisa cand pista se inchide
+class PlateEvent {
+public:
+    int trackId;
+    string text;
+    double confidence; //cea mai mica pondere a castigatorului pe o pozitie
+    uint64_t firstFrame, lastFrame;
+    int ocrRuns;
+    MyRect lastBox; //in coordonatele cadrului
+
+    PlateEvent() : trackId(-1), confidence(0.0), firstFrame(0), lastFrame(0), ocrRuns(0) {}
+};
+
+//voturile unei piste, grupate dupa numarul de caractere citite
+class TrackVotes {
+public:
+    void add(const PlateReading& reading);
+    //lungimea cu cele mai multe voturi, apoi castigatorul pe fiecare pozitie
+    string consensus(double& confidence) const;
+    //cate citiri au avut exact length caractere
+    int readings(int length) const;
+
+private:
+    map<int, vector<map<char, double>>> votes;
+    map<int, double> lengthWeight;
+    map<int, int> lengthReadings;
+};
+
+//consens OCR la nivel de pista: detectiile sunt asociate intre cadre (IoU, greedy), OCR-ul ruleaza
+//doar pe cadrele clare (masura de focus ieftina pe decupaj) si se opreste cand voturile converg,
+//iar la iesirea vehiculului din cadru se emite un singur eveniment cu textul final
+class PlateTracker {
+public:
+    PlateTracker(LicensePlateDetector& detector, const TrackerConfig& config);
+
+    //plates: detectiile cadrului, in coordonatele lui; intoarce evenimentele pistelor inchise acum
+    vector<PlateEvent> update(const Mat& frame, const vector<PlateCandidate>& plates);
+    //inchide toate pistele (sfarsitul fluxului)
+    vector<PlateEvent> flush();
+
+    //media lui |I(x+1) - I(x)|^2 pe luminanta, din doua in doua randuri
+    static double focusMeasure(const Mat& frame, const MyRect& box);
+
+    long long ocrCalls() const { return totalOcrRuns; }
+
+private:
+    struct Track {
+        int id;
+        MyRect box;
+        uint64_t firstFrame, lastFrame;
+        int missed = 0;
+        double bestFocus = 0.0;
+        uint64_t lastOcrFrame = 0;
+        int ocrRuns = 0;
+        bool converged = false;
+        TrackVotes votes;
+    };
+
+    void maybeRunOcr(Track& track, const Mat& frame);
+    bool close(Track& track, PlateEvent& event) const;
+
+    LicensePlateDetector& detector;
+    TrackerConfig config;
+    PlateOcr ocr;
+    vector<Track> tracks;
+    int nextId = 0;
+    uint64_t frameIndex = 0;
+    long long totalOcrRuns = 0;
+};
+
+#endif
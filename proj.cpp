@@ -1,27 +1,130 @@
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include "proj.h"
+#include "metrics.h"
+#include "stage_cache.h"
+#include "simd.h"
 #include <cmath> 
 #include <queue>
+#include <numeric>
 
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-LicensePlateDetector::LicensePlateDetector() {
-    aspectRatioMin = 2.0;
-    aspectRatioMax = 6.0;
-    minPlateArea = 1000;
-    maxPlateArea = 30000;
+LicensePlateDetector::LicensePlateDetector() : LicensePlateDetector(DetectorParams()) {
+}
+
+LicensePlateDetector::LicensePlateDetector(const DetectorParams& _params) {
+    params = _params;
+    showDebugWindows = true;
+    stageCache = nullptr;
+    roiMaskScale = 1;
+    frameScale = 1;
+}
+
+static int countActive(const Mat& mask) {
+    int count = 0;
+    for (int i = 0; i < mask.rows; i++) {
+        for (int j = 0; j < mask.cols; j++) {
+            count += mask.at<uchar>(i, j) > 0;
+        }
+    }
+    return count;
 }
 
 MyRect LicensePlateDetector::detectLicensePlate(const Mat& image) {
+    TraceSpan span("detectLicensePlate");
     Mat preprocessed = preprocessImage(image);
 
-    vector<MyRect> candidates = findPossiblePlateRegions(preprocessed);
+    vector<PlateCandidate> candidates = findPossiblePlateRegions(preprocessed);
+
+    MyRect plate;
+    {
+        StageTimer timer(STAGE_SELECTION);
+        plate = toFrameCoordinates(selectBestPlate(candidates, image));
+    }
+    Metrics::increment(plate.isEmpty() ? COUNTER_NO_PLATE_FRAMES : COUNTER_PLATES_FOUND);
+    return plate;
+}
+
+vector<PlateCandidate> LicensePlateDetector::detectLicensePlates(const Mat& image, int maxPlates) {
+    TraceSpan span("detectLicensePlates");
+    Mat preprocessed = preprocessImage(image);
+
+    vector<PlateCandidate> candidates = findPossiblePlateRegions(preprocessed);
+
+    vector<PlateCandidate> plates;
+    {
+        StageTimer timer(STAGE_SELECTION);
+        for (auto& candidate : candidates) {
+            candidate.score = scoreCandidate(candidate.rect);
+        }
+        plates = suppressOverlaps(candidates, maxPlates);
+        for (auto& plate : plates) {
+            plate.rect = toFrameCoordinates(plate.rect);
+            plate.rotated = toFrameCoordinates(plate.rotated);
+        }
+    }
 
-    return selectBestPlate(candidates, image);
+    if (plates.empty()) {
+        Metrics::increment(COUNTER_NO_PLATE_FRAMES);
+    } else {
+        Metrics::increment(COUNTER_PLATES_FOUND, plates.size());
+    }
+    return plates;
+}
+
+//pentru NV12/I420 primele height randuri sunt planul Y; crominanta nu ne trebuie
+Mat LicensePlateDetector::wrapFrame(const uchar* data, int width, int height, FrameFormat format, size_t stride) {
+    uchar* pixels = const_cast<uchar*>(data);
+    if (format == FrameFormat::BGR) {
+        return Mat(height, width, CV_8UC3, pixels, stride); //stride 0 == Mat::AUTO_STEP
+    }
+    return Mat(height, width, CV_8UC1, pixels, stride); //stride 0 == Mat::AUTO_STEP
+}
+
+MyRect LicensePlateDetector::detectLargestContour(const Mat& image) {
+    TraceSpan span("detectLargestContour");
+    int roiTop = (int)(image.rows * params.roiTopFraction);
+    setRegionOfInterest(vector<Rect>{Rect(0, roiTop, image.cols, image.rows - roiTop)});
+    Mat preprocessed = preprocessImage(image);
+    clearRegionOfInterest();
+
+    vector<ChainContour> contours;
+    {
+        StageTimer timer(STAGE_CONTOURS);
+        contours = manualTraceContours(preprocessed);
+    }
+
+    MyRect plate;
+    {
+        StageTimer timer(STAGE_SELECTION);
+        int maxArea = 0;
+        for (const auto& c : contours) {
+            if (c.isHole || c.parent >= 0) {
+                continue; //doar contururile exterioare de pe primul nivel
+            }
+            MyRect r = toFrameCoordinates(MyRect(c.bounds.x + frameCrop.x, c.bounds.y + frameCrop.y,
+                                                 c.bounds.width, c.bounds.height));
+            if (r.width * r.height > maxArea && r.width > r.height * params.selectionAspectMin && r.y > roiTop) {
+                maxArea = r.width * r.height;
+                plate = r;
+            }
+        }
+    }
+    Metrics::increment(plate.isEmpty() ? COUNTER_NO_PLATE_FRAMES : COUNTER_PLATES_FOUND);
+    return plate;
+}
+
+MyRect LicensePlateDetector::detectLicensePlate(const uchar* data, int width, int height, FrameFormat format, size_t stride) {
+    return detectLicensePlate(wrapFrame(data, width, height, format, stride));
+}
+
+vector<PlateCandidate> LicensePlateDetector::detectLicensePlates(const uchar* data, int width, int height, FrameFormat format,
+                                                                 int maxPlates, size_t stride) {
+    return detectLicensePlates(wrapFrame(data, width, height, format, stride), maxPlates);
 }
 
 Mat LicensePlateDetector::manualGrayscaleConversion(const Mat& image) {
@@ -36,6 +139,100 @@ Mat LicensePlateDetector::manualGrayscaleConversion(const Mat& image) {
     }
     return gray;
 }
+
+//cel mai mare factor intreg care lasa cadrul cel putin canonicalWidth de lat
+int LicensePlateDetector::normalizationFactor(int frameWidth) const {
+    return normalizationFactor(frameWidth, params.canonicalWidth);
+}
+
+int LicensePlateDetector::normalizationFactor(int frameWidth, int canonicalWidth) {
+    if (canonicalWidth <= 0 || frameWidth < 2 * canonicalWidth) {
+        return 1;
+    }
+    return frameWidth / canonicalWidth;
+}
+
+//aduna randul src (uchar) peste acumulatorul de 16 biti; 16 pixeli pe pas cu SSE2, 8 cu NEON
+static void accumulateRow(const uchar* src, ushort* acc, int n) {
+    int j = 0;
+#if defined(LPR_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; j + 16 <= n; j += 16) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + j));
+        __m128i lo = _mm_loadu_si128((const __m128i*)(acc + j));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(acc + j + 8));
+        _mm_storeu_si128((__m128i*)(acc + j), _mm_add_epi16(lo, _mm_unpacklo_epi8(pixels, zero)));
+        _mm_storeu_si128((__m128i*)(acc + j + 8), _mm_add_epi16(hi, _mm_unpackhi_epi8(pixels, zero)));
+    }
+#elif defined(LPR_NEON)
+    for (; j + 8 <= n; j += 8) {
+        vst1q_u16(acc + j, vaddw_u8(vld1q_u16(acc + j), vld1_u8(src + j)));
+    }
+#endif
+    for (; j < n; j++) {
+        acc[j] += src[j];
+    }
+}
+
+//reducere prin medie pe blocuri factor x factor (area/box): fiecare pixel de iesire e media
+//exacta, rotunjita, a blocului lui. Intai sumele pe verticala (factor randuri, SIMD, in 16 biti:
+//factor * 255 incape pentru factor <= 257), apoi sumele pe orizontala si impartirea, care ating
+//doar 1/factor din date. Marginile care nu formeaza un bloc intreg sunt ignorate.
+Mat LicensePlateDetector::manualAreaDownscale(const Mat& image, int factor) {
+    if (factor <= 1) {
+        return image;
+    }
+    //peste 257 sumele pe 16 biti ar depasi; o reducere mai mica e doar un cadru ceva mai mare
+    factor = min(factor, 257);
+    int channels = image.channels();
+    int outRows = image.rows / factor;
+    int outCols = image.cols / factor;
+    Mat result(outRows, outCols, CV_8UC(channels));
+    int rowLength = outCols * factor * channels;
+    int area = factor * factor;
+    vector<ushort> columnSums(rowLength);
+
+    for (int i = 0; i < outRows; i++) {
+        fill(columnSums.begin(), columnSums.end(), 0);
+        for (int k = 0; k < factor; k++) {
+            accumulateRow(image.ptr<uchar>(i * factor + k), columnSums.data(), rowLength);
+        }
+
+        uchar* dst = result.ptr<uchar>(i);
+        for (int j = 0; j < outCols; j++) {
+            const ushort* block = columnSums.data() + j * factor * channels;
+            for (int c = 0; c < channels; c++) {
+                unsigned sum = 0;
+                for (int t = 0; t < factor; t++) {
+                    sum += block[t * channels + c];
+                }
+                dst[j * channels + c] = (uchar)((sum + area / 2) / area);
+            }
+        }
+    }
+    return result;
+}
+
+//intai media pe blocuri (pe toate canalele), apoi conversia in gri doar pe cadrul mic;
+//formatele GRAY/NV12/I420 vin deja ca plan Y
+Mat LicensePlateDetector::decimatedLuma(const Mat& frame, int minWidth) {
+    int factor = max(1, frame.cols / max(1, minWidth));
+    Mat small = manualAreaDownscale(frame, factor);
+    if (small.channels() == 1) {
+        return small;
+    }
+    Mat luma(small.rows, small.cols, CV_8UC1);
+    for (int i = 0; i < small.rows; i++) {
+        const uchar* src = small.ptr<uchar>(i);
+        uchar* dst = luma.ptr<uchar>(i);
+        for (int j = 0; j < small.cols; j++) {
+            //0.299/0.587/0.114 in virgula fixa pe 8 biti
+            dst[j] = (uchar)((29 * src[3 * j] + 150 * src[3 * j + 1] + 77 * src[3 * j + 2] + 128) >> 8);
+        }
+    }
+    return luma;
+}
+
 //reduce zgomot si detalii minore -> blur pe baza functiei gaussiene
 Mat LicensePlateDetector::manualGaussianBlur(const Mat& image, int kernelSize) { //kernel = 7-> -3 -2 -1...3
     Mat blurred = image.clone();
@@ -163,33 +360,128 @@ Mat LicensePlateDetector::manualThreshold(const Mat& image, int threshold) {
     
     return result;
 }
+//cascada pe tile-uri: un tile fara energie de muchii sau fara tranzitii orizontale
+//(cer, asfalt, caroserie) nu poate contine caractere
+Mat LicensePlateDetector::findActiveTiles(const Mat& edges, const Mat& binary) {
+    int tileSize = params.tileSize;
+    int tileRows = (edges.rows + tileSize - 1) / tileSize;
+    int tileCols = (edges.cols + tileSize - 1) / tileSize;
+    vector<long long> energy(tileRows * tileCols, 0);
+    vector<int> transitions(tileRows * tileCols, 0);
+
+    for (int i = 0; i < edges.rows; i++) {
+        const uchar* e = edges.ptr<uchar>(i);
+        const uchar* b = binary.ptr<uchar>(i);
+        int base = (i / tileSize) * tileCols;
+        for (int j = 0; j < edges.cols; j++) {
+            int t = base + j / tileSize;
+            energy[t] += e[j];
+            if (j > 0 && b[j] != b[j - 1]) {
+                transitions[t]++;
+            }
+        }
+    }
+
+    Mat passed = Mat::zeros(tileRows, tileCols, CV_8UC1);
+    for (int ti = 0; ti < tileRows; ti++) {
+        for (int tj = 0; tj < tileCols; tj++) {
+            int h = min(tileSize, edges.rows - ti * tileSize);
+            int w = min(tileSize, edges.cols - tj * tileSize);
+            int t = ti * tileCols + tj;
+            double meanEnergy = (double)energy[t] / (w * h);
+            if (meanEnergy >= params.tileMinEnergy && transitions[t] >= params.tileMinTransitions) {
+                passed.at<uchar>(ti, tj) = 255;
+            }
+        }
+    }
+
+    //dilatare cu un tile, ca marginile placutei sa nu fie taiate
+    Mat active = Mat::zeros(tileRows, tileCols, CV_8UC1);
+    for (int ti = 0; ti < tileRows; ti++) {
+        for (int tj = 0; tj < tileCols; tj++) {
+            bool hit = false;
+            for (int di = -1; di <= 1 && !hit; di++) {
+                for (int dj = -1; dj <= 1 && !hit; dj++) {
+                    int ni = ti + di;
+                    int nj = tj + dj;
+                    hit = ni >= 0 && ni < tileRows && nj >= 0 && nj < tileCols && passed.at<uchar>(ni, nj) > 0;
+                }
+            }
+            active.at<uchar>(ti, tj) = hit ? 255 : 0;
+        }
+    }
+
+    stats.tilesTotal += tileRows * tileCols;
+    stats.tilesRejected += tileRows * tileCols - countActive(active);
+
+    return active;
+}
+
+//tile-urile active alaturate pe acelasi rand sunt unite intr-un singur dreptunghi
+static vector<Rect> activeTileRects(const Mat& activeTiles, Size imageSize, int tileSize) {
+    vector<Rect> rects;
+    if (activeTiles.empty()) {
+        rects.push_back(Rect(0, 0, imageSize.width, imageSize.height));
+        return rects;
+    }
+
+    for (int ti = 0; ti < activeTiles.rows; ti++) {
+        int tj = 0;
+        while (tj < activeTiles.cols) {
+            if (activeTiles.at<uchar>(ti, tj) == 0) {
+                tj++;
+                continue;
+            }
+            int start = tj;
+            while (tj < activeTiles.cols && activeTiles.at<uchar>(ti, tj) > 0) {
+                tj++;
+            }
+            int x = start * tileSize;
+            int y = ti * tileSize;
+            rects.push_back(Rect(x, y, min(tj * tileSize, imageSize.width) - x, min(y + tileSize, imageSize.height) - y));
+        }
+    }
+    return rects;
+}
+
 //uneste componentele conectate si reduce zgomotul
 Mat LicensePlateDetector::manualMorphologicalOperation(const Mat& image) {
+    return manualMorphologicalOperation(image, Mat());
+}
 
-    int width = 17;
-    int height = 3;
+//activeTiles goala -> toata imaginea; altfel doar tile-urile active (plus vecinatatea kernelului)
+Mat LicensePlateDetector::manualMorphologicalOperation(const Mat& image, const Mat& activeTiles) {
+
+    int width = params.morphWidth;
+    int height = params.morphHeight;
     Mat element = Mat::ones(height, width, CV_8UC1);//conecteaza componentele orizontale
     
     // Dilate
     Mat dilated = Mat::zeros(image.size(), image.type());
     int halfWidth = width / 2;
     int halfHeight = height / 2;
+    vector<Rect> regions = activeTileRects(activeTiles, image.size(), params.tileSize);
 
     //kernelul(element) este plasat peste pixel(i,j)
     //daca kernelul intalneste cel putin un pixel alb atunci (i,j) devine alb
     //daca nu, devine negru
-    for (int i = halfHeight; i < image.rows - halfHeight; i++) {
-        for (int j = halfWidth; j < image.cols - halfWidth; j++) {
-            bool hit = false;
-            for (int ki = -halfHeight; ki <= halfHeight && !hit; ki++) {
-                for (int kj = -halfWidth; kj <= halfWidth && !hit; kj++) {
-                    if (element.at<uchar>(ki + halfHeight, kj + halfWidth) > 0 &&
-                        image.at<uchar>(i + ki, j + kj) > 0) {
-                        hit = true;
+    //erodarea unei regiuni citeste dilatarea si din jurul ei, deci o calculam cu halo
+    for (const Rect& r : regions) {
+        int iEnd = min(image.rows - halfHeight, r.y + r.height + halfHeight);
+        int jEnd = min(image.cols - halfWidth, r.x + r.width + halfWidth);
+        for (int i = max(halfHeight, r.y - halfHeight); i < iEnd; i++) {
+            for (int j = max(halfWidth, r.x - halfWidth); j < jEnd; j++) {
+                bool hit = false;
+                for (int ki = -halfHeight; ki <= halfHeight && !hit; ki++) {
+                    for (int kj = -halfWidth; kj <= halfWidth && !hit; kj++) {
+                        if (element.at<uchar>(ki + halfHeight, kj + halfWidth) > 0 &&
+                            image.at<uchar>(i + ki, j + kj) > 0) {
+                            hit = true;
+                        }
                     }
                 }
+                dilated.at<uchar>(i, j) = hit ? 255 : 0;
             }
-            dilated.at<uchar>(i, j) = hit ? 255 : 0;
         }
     }
     
@@ -199,20 +491,24 @@ Mat LicensePlateDetector::manualMorphologicalOperation(const Mat& image) {
     //daca orice pixel din kernel nu corespunde, pixelul (i,j) devine negru(0)
     Mat eroded = Mat::zeros(dilated.size(), dilated.type());
     
-    for (int i = halfHeight; i < dilated.rows - halfHeight; i++) {
-        for (int j = halfWidth; j < dilated.cols - halfWidth; j++) {
-            bool fit = true;
-
-            for (int ki = -halfHeight; ki <= halfHeight && fit; ki++) {
-                for (int kj = -halfWidth; kj <= halfWidth && fit; kj++) {
-                    if (element.at<uchar>(ki + halfHeight, kj + halfWidth) > 0 &&
-                        dilated.at<uchar>(i + ki, j + kj) == 0) {
-                        fit = false;
+    for (const Rect& r : regions) {
+        int iEnd = min(dilated.rows - halfHeight, r.y + r.height);
+        int jEnd = min(dilated.cols - halfWidth, r.x + r.width);
+        for (int i = max(halfHeight, r.y); i < iEnd; i++) {
+            for (int j = max(halfWidth, r.x); j < jEnd; j++) {
+                bool fit = true;
+
+                for (int ki = -halfHeight; ki <= halfHeight && fit; ki++) {
+                    for (int kj = -halfWidth; kj <= halfWidth && fit; kj++) {
+                        if (element.at<uchar>(ki + halfHeight, kj + halfWidth) > 0 &&
+                            dilated.at<uchar>(i + ki, j + kj) == 0) {
+                            fit = false;
+                        }
                     }
                 }
+                
+                eroded.at<uchar>(i, j) = fit ? 255 : 0;
             }
-            
-            eroded.at<uchar>(i, j) = fit ? 255 : 0;
         }
     }
     
@@ -221,105 +517,801 @@ Mat LicensePlateDetector::manualMorphologicalOperation(const Mat& image) {
 //cautam pixeli albi si ii exploram in BFS
 //de ce alb? pentru ca intr-o imagine binara un contur este alb iar restul e negru
 vector<vector<Point>> LicensePlateDetector::manualFindContours(const Mat& image) {
+    return manualFindContours(image, Mat());
+}
+
+//pixelii de start se cauta doar in tile-urile active; BFS-ul poate trece in afara lor
+vector<vector<Point>> LicensePlateDetector::manualFindContours(const Mat& image, const Mat& activeTiles) {
     Mat visited = Mat::zeros(image.size(), CV_8UC1);
     vector<vector<Point>> contours;
 
     int dx[] = {-1, -1, -1, 0, 0, 1, 1, 1};
     int dy[] = {-1, 0, 1, -1, 1, -1, 0, 1};
 
+    for (const Rect& r : activeTileRects(activeTiles, image.size(), params.tileSize)) {
+        for (int i = r.y; i < r.y + r.height; i++) {
+            for (int j = r.x; j < r.x + r.width; j++) {
+                //pixel alb si nevizitat
+                if (image.at<uchar>(i, j) == 255 && visited.at<uchar>(i, j) == 0) {
+                    vector<Point> contour;
+                    queue<Point> q; //coada pentru bfs
+                    q.push(Point(j, i));
+                    visited.at<uchar>(i, j) = 255;
+
+                    while (!q.empty()) {
+                        Point p = q.front();
+                        q.pop();
+                        contour.push_back(p); //fiecare pixel alb este adaugat intr-un contur
+
+                        for (int k = 0; k < 8; k++) {
+                            int nx = p.x + dx[k];
+                            int ny = p.y + dy[k];
+                            
+                            if (nx >= 0 && nx < image.cols && ny >= 0 && ny < image.rows &&
+                                image.at<uchar>(ny, nx) == 255 && visited.at<uchar>(ny, nx) == 0) {
+                                q.push(Point(nx, ny));
+                                visited.at<uchar>(ny, nx) = 255;
+                            }
+                        }
+                    }
+
+                    if ((int)contour.size() > params.minContourPixels) { //sunt considerate zgomot
+                        contours.push_back(contour);
+                    }
+                }
+            }
+        }
+    }
+    
+    return contours;
+}
+
+//directiile Freeman in ordine trigonometrica pe ecran (y creste in jos)
+static const int chainDx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int chainDy[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+
+Point ChainContour::step(int code) {
+    return Point(chainDx[code & 7], chainDy[code & 7]);
+}
+
+//ultimul pas se intoarce in punctul de start, deci nu mai e adaugat
+vector<Point> ChainContour::points() const {
+    vector<Point> result;
+    result.reserve(codes.size() + 1);
+    Point p = start;
+    result.push_back(p);
+    for (size_t k = 0; k + 1 < codes.size(); k++) {
+        p = p + step(codes[k]);
+        result.push_back(p);
+    }
+    return result;
+}
+
+double ChainContour::area() const {
+    long long twiceArea = 0;
+    int x = start.x, y = start.y;
+    for (uchar code : codes) {
+        int dx = chainDx[code], dy = chainDy[code];
+        twiceArea += (long long)x * dy - (long long)y * dx;
+        x += dx;
+        y += dy;
+    }
+    return fabs((double)twiceArea) / 2.0;
+}
+
+//Pick: interior + margine = A + B/2 + 1, cu B = numarul de pasi ai lantului
+double ChainContour::pixelCount() const {
+    return area() + codes.size() / 2.0 + 1.0;
+}
+
+void MyRotatedRect::corners(Point2f out[4]) const {
+    float radians = angle * (float)M_PI / 180.0f;
+    float ux = cos(radians) * width / 2, uy = sin(radians) * width / 2;
+    float vx = -sin(radians) * height / 2, vy = cos(radians) * height / 2;
+    out[0] = Point2f(center.x - ux - vx, center.y - uy - vy);
+    out[1] = Point2f(center.x + ux - vx, center.y + uy - vy);
+    out[2] = Point2f(center.x + ux + vx, center.y + uy + vy);
+    out[3] = Point2f(center.x - ux + vx, center.y - uy + vy);
+}
+
+MyRect MyRotatedRect::boundingRect() const {
+    Point2f c[4];
+    corners(c);
+    float minX = c[0].x, maxX = c[0].x, minY = c[0].y, maxY = c[0].y;
+    for (int k = 1; k < 4; k++) {
+        minX = min(minX, c[k].x);
+        maxX = max(maxX, c[k].x);
+        minY = min(minY, c[k].y);
+        maxY = max(maxY, c[k].y);
+    }
+    int x = cvFloor(minX), y = cvFloor(minY);
+    return MyRect(x, y, cvCeil(maxX) - x, cvCeil(maxY) - y);
+}
+
+static long long cross(const Point& o, const Point& a, const Point& b) {
+    return (long long)(a.x - o.x) * (b.y - o.y) - (long long)(a.y - o.y) * (b.x - o.x);
+}
+
+//lantul monoton al lui Andrew: sortare, apoi jumatatea de jos si cea de sus; varfurile
+//coliniare sunt eliminate, rezultatul e in ordine trigonometrica (in coordonate x, y)
+vector<Point> LicensePlateDetector::convexHull(vector<Point> points) {
+    sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    });
+    points.erase(unique(points.begin(), points.end()), points.end());
+    if (points.size() < 3) {
+        return points;
+    }
+
+    vector<Point> hull(2 * points.size());
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+            k--;
+        }
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = k + 1; i > 0; i--) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) {
+            k--;
+        }
+        hull[k++] = points[i - 1];
+    }
+    hull.resize(k - 1); //ultimul punct e din nou primul
+    return hull;
+}
+
+//unghiul directiei (dx, dy) in grade, adus in (-90, 90]
+static float lineAngle(double dx, double dy) {
+    double degrees = atan2(dy, dx) * 180.0 / M_PI;
+    if (degrees <= -90) {
+        degrees += 180;
+    } else if (degrees > 90) {
+        degrees -= 180;
+    }
+    return (float)degrees;
+}
+
+//dreptunghiul de arie minima are o latura pe o muchie a infasuratorii. Pentru fiecare muchie,
+//trei "etriere" (cel mai departe inainte, cel mai departe inapoi, cel mai departe in interior)
+//avanseaza doar inainte pe infasuratoare, deci totul e O(n). Punctele sunt centre de pixel,
+//asa ca dimensiunile primesc +1, ca la MyRect.
+MyRotatedRect LicensePlateDetector::minAreaRotatedRect(const vector<Point>& hull) {
+    int n = (int)hull.size();
+    if (n == 0) {
+        return MyRotatedRect();
+    }
+    if (n == 1) {
+        return MyRotatedRect(Point2f((float)hull[0].x, (float)hull[0].y), 1, 1, 0);
+    }
+    if (n == 2) {
+        double dx = hull[1].x - hull[0].x, dy = hull[1].y - hull[0].y;
+        Point2f center((hull[0].x + hull[1].x) / 2.0f, (hull[0].y + hull[1].y) / 2.0f);
+        return MyRotatedRect(center, (float)sqrt(dx * dx + dy * dy) + 1, 1, lineAngle(dx, dy));
+    }
+
+    auto along = [&](int i, double ux, double uy, int p) {
+        return (hull[p].x - hull[i].x) * ux + (hull[p].y - hull[i].y) * uy;
+    };
+
+    double bestArea = -1;
+    MyRotatedRect best;
+    int right = 0, top = 0, left = 0;
+    for (int i = 0; i < n; i++) {
+        int j = (i + 1) % n;
+        double ex = hull[j].x - hull[i].x, ey = hull[j].y - hull[i].y;
+        double length = sqrt(ex * ex + ey * ey);
+        double ux = ex / length, uy = ey / length;
+        double vx = -uy, vy = ux; //normala spre interior (infasuratoarea e in sens trigonometric)
+
+        if (i == 0) {
+            for (int p = 0; p < n; p++) {
+                if (along(i, ux, uy, p) > along(i, ux, uy, right)) right = p;
+                if (along(i, vx, vy, p) > along(i, vx, vy, top)) top = p;
+                if (along(i, ux, uy, p) < along(i, ux, uy, left)) left = p;
+            }
+        } else {
+            for (int steps = 0; steps < n && along(i, ux, uy, (right + 1) % n) >= along(i, ux, uy, right); steps++) {
+                right = (right + 1) % n;
+            }
+            for (int steps = 0; steps < n && along(i, vx, vy, (top + 1) % n) >= along(i, vx, vy, top); steps++) {
+                top = (top + 1) % n;
+            }
+            for (int steps = 0; steps < n && along(i, ux, uy, (left + 1) % n) <= along(i, ux, uy, left); steps++) {
+                left = (left + 1) % n;
+            }
+        }
+
+        double minU = along(i, ux, uy, left);
+        double maxU = along(i, ux, uy, right);
+        double maxV = along(i, vx, vy, top);
+        double w = maxU - minU + 1;
+        double h = maxV + 1;
+        if (bestArea < 0 || w * h < bestArea) {
+            bestArea = w * h;
+            double cu = (minU + maxU) / 2, cv = maxV / 2;
+            Point2f center((float)(hull[i].x + ux * cu + vx * cv), (float)(hull[i].y + uy * cu + vy * cv));
+            if (w >= h) {
+                best = MyRotatedRect(center, (float)w, (float)h, lineAngle(ux, uy));
+            } else {
+                best = MyRotatedRect(center, (float)h, (float)w, lineAngle(vx, vy));
+            }
+        }
+    }
+    return best;
+}
+
+//Suzuki & Abe (1985): scanare raster, iar la fiecare pixel de start al unei margini noi
+//(exterioara: alb cu vecin stang negru; gaura: alb cu vecin drept negru) marginea e urmarita
+//si etichetata cu NBD, ca sa nu mai fie pornita a doua oara. LNBD (ultima margine intalnita
+//pe rand) da parintele. Eticheta -NBD marcheaza pixelii al caror vecin din dreapta e fundal.
+vector<ChainContour> LicensePlateDetector::manualTraceContours(const Mat& image) {
+    //etichete cu o rama de zero, ca vecinii sa existe mereu
+    int rows = image.rows + 2;
+    int cols = image.cols + 2;
+    vector<int> label((size_t)rows * cols, 0);
     for (int i = 0; i < image.rows; i++) {
+        const uchar* src = image.ptr<uchar>(i);
+        int* dst = label.data() + (size_t)(i + 1) * cols + 1;
         for (int j = 0; j < image.cols; j++) {
-            //pixel alb si nevizitat
-            if (image.at<uchar>(i, j) == 255 && visited.at<uchar>(i, j) == 0) {
-                vector<Point> contour;
-                queue<Point> q; //coada pentru bfs
-                q.push(Point(j, i));
-                visited.at<uchar>(i, j) = 255;
-
-                while (!q.empty()) {
-                    Point p = q.front();
-                    q.pop();
-                    contour.push_back(p); //fiecare pixel alb este adaugat intr-un contur
-
-                    for (int k = 0; k < 8; k++) {
-                        int nx = p.x + dx[k];
-                        int ny = p.y + dy[k];
-                        
-                        if (nx >= 0 && nx < image.cols && ny >= 0 && ny < image.rows &&
-                            image.at<uchar>(ny, nx) == 255 && visited.at<uchar>(ny, nx) == 0) {
-                            q.push(Point(nx, ny));
-                            visited.at<uchar>(ny, nx) = 255;
+            dst[j] = src[j] > 0;
+        }
+    }
+    const int offsets[8] = {1, -cols + 1, -cols, -cols - 1, -1, cols - 1, cols, cols + 1};
+
+    //NBD 1 e rama, tratata ca o gaura fara parinte; conturul cu NBD n are indexul n - 2
+    vector<ChainContour> contours;
+    auto isHoleBorder = [&](int nbd) { return nbd == 1 || contours[nbd - 2].isHole; };
+    auto parentOf = [&](int nbd) { return nbd == 1 ? -1 : contours[nbd - 2].parent; };
+
+    for (int i = 1; i < rows - 1; i++) {
+        int lnbd = 1;
+        for (int j = 1; j < cols - 1; j++) {
+            int start = i * cols + j;
+            int value = label[start];
+            if (value == 0) {
+                continue;
+            }
+            bool outer = value == 1 && label[start - 1] == 0;
+            bool hole = !outer && value >= 1 && label[start + 1] == 0;
+
+            if (outer || hole) {
+                int nbd = (int)contours.size() + 2;
+                if (hole && value > 1) {
+                    lnbd = value;
+                }
+                ChainContour contour;
+                contour.isHole = hole;
+                //acelasi tip ca marginea LNBD -> frati, altfel LNBD e parintele
+                contour.parent = hole == isHoleBorder(lnbd) ? parentOf(lnbd) : (lnbd == 1 ? -1 : lnbd - 2);
+                contour.start = Point(j - 1, i - 1);
+                int minX = j, maxX = j, minY = i, maxY = i;
+
+                //primul vecin alb, in sens orar, pornind de la fundalul care a declansat startul
+                int s = hole ? 0 : 4;
+                int searchEnd = s;
+                int first = -1;
+                do {
+                    s = (s - 1) & 7;
+                    if (label[start + offsets[s]] != 0) {
+                        first = start + offsets[s];
+                    }
+                } while (first < 0 && s != searchEnd);
+
+                if (first < 0) {
+                    label[start] = -nbd; //pixel izolat
+                } else {
+                    int current = start;
+                    int x = j, y = i;
+                    for (;;) {
+                        //urmatorul vecin alb in sens trigonometric, dupa cel din care am venit
+                        searchEnd = s;
+                        int k = s;
+                        int next;
+                        do {
+                            k++;
+                            next = current + offsets[k & 7];
+                        } while (label[next] == 0);
+                        int dir = k & 7;
+
+                        //vecinul din dreapta a fost examinat si e fundal
+                        if ((unsigned)(dir - 1) < (unsigned)searchEnd) {
+                            label[current] = -nbd;
+                        } else if (label[current] == 1) {
+                            label[current] = nbd;
                         }
+
+                        contour.codes.push_back((uchar)dir);
+                        x += chainDx[dir];
+                        y += chainDy[dir];
+                        minX = min(minX, x);
+                        maxX = max(maxX, x);
+                        minY = min(minY, y);
+                        maxY = max(maxY, y);
+
+                        if (next == start && current == first) {
+                            break;
+                        }
+                        current = next;
+                        s = (dir + 4) & 7;
                     }
                 }
 
-                if (contour.size() > 50) { //sunt considerate zgomot
-                    contours.push_back(contour);
-                }
+                contour.bounds = MyRect(minX - 1, minY - 1, maxX - minX + 1, maxY - minY + 1);
+                contours.push_back(move(contour));
+            }
+
+            if (label[start] != 1) {
+                lnbd = abs(label[start]);
             }
         }
     }
-    
+
     return contours;
 }
 
+void LicensePlateDetector::setRegionOfInterest(const vector<Rect>& rects) {
+    roiRects = rects;
+    roiPolygon.clear();
+    roiMask = Mat();
+}
+
+void LicensePlateDetector::setRegionOfInterest(const vector<Point>& polygon) {
+    roiRects.clear();
+    roiPolygon = polygon;
+    roiMask = Mat();
+}
+
+void LicensePlateDetector::clearRegionOfInterest() {
+    roiRects.clear();
+    roiPolygon.clear();
+    roiMask = Mat();
+}
+
+//dreptunghiul minim din cadrul redus care acopera r
+static Rect scaleDown(const Rect& r, int scale) {
+    int x1 = cvFloor((double)r.x / scale);
+    int y1 = cvFloor((double)r.y / scale);
+    int x2 = cvCeil((double)(r.x + r.width) / scale);
+    int y2 = cvCeil((double)(r.y + r.height) / scale);
+    return Rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+//masca ROI se rasterizeaza o singura data pentru fiecare dimensiune de cadru (si factor de reducere)
+const Mat& LicensePlateDetector::regionOfInterestMask(Size frameSize, int scale) {
+    if (roiRects.empty() && roiPolygon.empty()) {
+        roiMask = Mat();
+        return roiMask;
+    }
+    Size scaledSize(frameSize.width / scale, frameSize.height / scale);
+    if (roiMask.size() == scaledSize && roiMaskScale == scale) {
+        return roiMask;
+    }
+
+    roiMask = Mat::zeros(scaledSize, CV_8UC1);
+    roiMaskScale = scale;
+    if (!roiPolygon.empty()) {
+        vector<Point> polygon;
+        polygon.reserve(roiPolygon.size());
+        for (const Point& p : roiPolygon) {
+            polygon.push_back(Point(cvRound((double)p.x / scale), cvRound((double)p.y / scale)));
+        }
+        fillPoly(roiMask, vector<vector<Point>>{polygon}, Scalar(255));
+    }
+    Rect frame(0, 0, scaledSize.width, scaledSize.height);
+    for (const Rect& r : roiRects) {
+        roiMask(scaleDown(r, scale) & frame).setTo(Scalar(255));
+    }
+    return roiMask;
+}
+
+//dreptunghiul procesat: ROI plus halo-ul de care au nevoie blur, Sobel (1)
+//si dilatare+erodare (de doua ori jumatatea elementului), plus un pixel de siguranta
+Rect LicensePlateDetector::regionOfInterestCrop(Size frameSize, int scale) {
+    Rect frame(0, 0, frameSize.width / scale, frameSize.height / scale);
+    if (roiRects.empty() && roiPolygon.empty()) {
+        return frame;
+    }
+
+    Rect bounds;
+    if (!roiPolygon.empty()) {
+        bounds = boundingRect(roiPolygon);
+    }
+    for (const Rect& r : roiRects) {
+        bounds = bounds.empty() ? r : (bounds | r);
+    }
+    bounds = scaleDown(bounds, scale);
+
+    const int haloX = 2 * (params.morphWidth / 2) + 1 + params.blurKernelSize / 2 + 1;
+    const int haloY = 2 * (params.morphHeight / 2) + 1 + params.blurKernelSize / 2 + 1;
+    Rect crop(bounds.x - haloX, bounds.y - haloY, bounds.width + 2 * haloX, bounds.height + 2 * haloY);
+    return crop & frame;
+}
+
+//etapele timpurii (gri, blur, Sobel, prag). Cu un StageCache setat, fiecare etapa e luata
+//din cache cand imaginea si parametrii din amonte sunt aceiasi; gray/blurred pot ramane
+//goale daca etapele de dupa ele au fost gasite in cache
+void LicensePlateDetector::computeEdgeMaps(const Mat& view, Mat& gray, Mat& blurred, Mat& edges, Mat& binary) {
+    uint64_t imageKey = 0;
+    uint64_t blurKey = 0;
+    bool haveBlurred = false;
+    if (stageCache != nullptr) {
+        imageKey = StageCache::hashImage(view);
+        blurKey = StageCache::combine(imageKey, (uint64_t)params.blurKernelSize);
+        //Sobel si pragul Otsu nu au parametri, deci depind doar de cheia blur-ului
+        if (stageCache->lookup(STAGE_SOBEL, blurKey, edges) && stageCache->lookup(STAGE_THRESHOLD, blurKey, binary)) {
+            return;
+        }
+        haveBlurred = stageCache->lookup(STAGE_BLUR, blurKey, blurred);
+    }
+
+    if (!haveBlurred) {
+        bool haveGray = stageCache != nullptr && view.channels() != 1 &&
+                        stageCache->lookup(STAGE_GRAYSCALE, imageKey, gray);
+        if (!haveGray) {
+            //luminanta primita direct (GRAY/NV12/I420) sare peste conversia in gri
+            StageTimer timer(STAGE_GRAYSCALE);
+            gray = view.channels() == 1 ? view : manualGrayscaleConversion(view);
+            //un plan de luminanta e memoria apelantului, nu il pastram in cache
+            if (stageCache != nullptr && view.channels() != 1) {
+                stageCache->store(STAGE_GRAYSCALE, imageKey, gray);
+            }
+        }
+        {
+            StageTimer timer(STAGE_BLUR);
+            blurred = manualGaussianBlur(gray, params.blurKernelSize);
+        }
+        if (stageCache != nullptr) {
+            stageCache->store(STAGE_BLUR, blurKey, blurred);
+        }
+    }
+
+    {
+        StageTimer timer(STAGE_SOBEL);
+        edges = manualSobelOperator(blurred);
+    }
+    {
+        StageTimer timer(STAGE_THRESHOLD);
+        binary = manualThreshold(edges, 0); // Otsu method
+    }
+    if (stageCache != nullptr) {
+        stageCache->store(STAGE_SOBEL, blurKey, edges);
+        stageCache->store(STAGE_THRESHOLD, blurKey, binary);
+    }
+}
+
 Mat LicensePlateDetector::preprocessImage(const Mat& image) {
 
-    Mat gray = manualGrayscaleConversion(image);
-    Mat blurred = manualGaussianBlur(gray, 5);
-    Mat edges = manualSobelOperator(blurred);
-    Mat binary = manualThreshold(edges, 0); // Otsu method
-    Mat morphed = manualMorphologicalOperation(binary);
-
-    imshow("Gray", gray);
-    imshow("Blurred", blurred);
-    imshow("Edges", edges);
-    imshow("Binary", binary);
-    imshow("Morphed", morphed);
+    //toate etapele ruleaza doar pe ROI + halo; la rezolutia originala e un view, fara copiere.
+    //Cadrele mari sunt reduse inainte de orice altceva, deci costul nu mai depinde de camera
+    frameScale = normalizationFactor(image.cols);
+    frameCrop = regionOfInterestCrop(image.size(), frameScale);
+    Mat view;
+    if (frameScale == 1) {
+        view = image(frameCrop);
+    } else {
+        StageTimer timer(STAGE_RESIZE);
+        Rect source(frameCrop.x * frameScale, frameCrop.y * frameScale,
+                    frameCrop.width * frameScale, frameCrop.height * frameScale);
+        view = manualAreaDownscale(image(source), frameScale);
+    }
+
+    //fiecare etapa e cronometrata separat pentru metrici
+    Mat gray, blurred, edges, binary, morphed;
+    computeEdgeMaps(view, gray, blurred, edges, binary);
+    {
+        StageTimer timer(STAGE_TILE_CASCADE);
+        activeTiles = params.useTileCascade ? findActiveTiles(edges, binary) : Mat();
+        const Mat& mask = regionOfInterestMask(image.size(), frameScale);
+        if (!mask.empty()) {
+            activeTiles = restrictTilesToMask(activeTiles, mask(frameCrop));
+        }
+    }
+    stats.framesProcessed++;
+    Metrics::increment(COUNTER_FRAMES_PROCESSED);
+
+    {
+        StageTimer timer(STAGE_MORPHOLOGY);
+        morphed = manualMorphologicalOperation(binary, activeTiles);
+    }
+
+    scorer.build(edges, binary, frameCrop.tl());
+
+    if (showDebugWindows) {
+        if (!gray.empty()) {
+            imshow("Gray", gray);
+        }
+        if (!blurred.empty()) {
+            imshow("Blurred", blurred);
+        }
+        imshow("Edges", edges);
+        imshow("Binary", binary);
+        imshow("Morphed", morphed);
+    }
     
     return morphed;
 }
 
-vector<MyRect> LicensePlateDetector::findPossiblePlateRegions(const Mat& image) {
-    vector<vector<Point>> contours = manualFindContours(image);
-    vector<MyRect> candidates;
+//pastreaza doar tile-urile care ating masca (sau vecinii lor, pentru halo)
+Mat LicensePlateDetector::restrictTilesToMask(const Mat& tiles, const Mat& mask) {
+    int tileSize = params.tileSize;
+    int tileRows = (mask.rows + tileSize - 1) / tileSize;
+    int tileCols = (mask.cols + tileSize - 1) / tileSize;
+    Mat inside = Mat::zeros(tileRows, tileCols, CV_8UC1);
+    for (int i = 0; i < mask.rows; i++) {
+        const uchar* m = mask.ptr<uchar>(i);
+        uchar* t = inside.ptr<uchar>(i / tileSize);
+        for (int j = 0; j < mask.cols; j++) {
+            if (m[j] > 0) {
+                t[j / tileSize] = 255;
+            }
+        }
+    }
+
+    Mat restricted = Mat::zeros(tileRows, tileCols, CV_8UC1);
+    for (int ti = 0; ti < tileRows; ti++) {
+        for (int tj = 0; tj < tileCols; tj++) {
+            if (!tiles.empty() && tiles.at<uchar>(ti, tj) == 0) {
+                continue;
+            }
+            bool near = false;
+            for (int di = -1; di <= 1 && !near; di++) {
+                for (int dj = -1; dj <= 1 && !near; dj++) {
+                    int ni = ti + di;
+                    int nj = tj + dj;
+                    near = ni >= 0 && ni < tileRows && nj >= 0 && nj < tileCols && inside.at<uchar>(ni, nj) > 0;
+                }
+            }
+            restricted.at<uchar>(ti, tj) = near ? 255 : 0;
+        }
+    }
+    return restricted;
+}
+
+vector<PlateCandidate> LicensePlateDetector::findPossiblePlateRegions(const Mat& image) {
+    StageTimer timer(STAGE_CONTOURS);
+    //doar marginile exterioare; dupa morfologie imaginea e neagra in afara tile-urilor active,
+    //deci nu mai e nevoie de restrictia pe tile-uri de la cautarea prin BFS
+    vector<ChainContour> contours = manualTraceContours(image);
+    vector<MyRect> components;
+    vector<vector<Point>> hulls; //infasuratoarea fiecarei componente, in coordonatele cadrului
+    components.reserve(contours.size());
 
     for (const auto& contour : contours) {
-        int minX = image.cols, minY = image.rows, maxX = 0, maxY = 0;
-        
-        for (const auto& point : contour) {
-            minX = min(minX, point.x);
-            minY = min(minY, point.y);
-            maxX = max(maxX, point.x);
-            maxY = max(maxY, point.y);
+        if (contour.isHole || contour.pixelCount() <= params.minContourPixels) { //sunt considerate zgomot
+            continue;
+        }
+        //inapoi in coordonatele cadrului intreg
+        components.emplace_back(contour.bounds.x + frameCrop.x, contour.bounds.y + frameCrop.y,
+                                contour.bounds.width, contour.bounds.height);
+        if (params.useRotatedBoxes) {
+            vector<Point> points = contour.points();
+            for (auto& point : points) {
+                point = point + frameCrop.tl();
+            }
+            hulls.push_back(convexHull(move(points)));
         }
+    }
+
+    //morfologia poate rupe o placuta in mai multe bucati alaturate
+    vector<vector<int>> members;
+    vector<MyRect> merged = mergePlateFragments(components, members);
 
-        MyRect rect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+    vector<PlateCandidate> candidates;
+    for (size_t g = 0; g < merged.size(); g++) {
+        const MyRect& rect = merged[g];
         double area = rect.width * rect.height;
+        //dreptunghiul rotit are aria cel mult cat cel aliniat, deci un candidat prea mic e respins direct
+        if (area < params.minPlateArea || !insideRegionOfInterest(rect)) {
+            continue;
+        }
         double aspectRatio = (double)rect.width / rect.height;
-        
-        if (area >= minPlateArea && area <= maxPlateArea && 
-            aspectRatio >= aspectRatioMin && aspectRatio <= aspectRatioMax) {
-            candidates.push_back(rect);
+
+        PlateCandidate candidate(rect, 0.0);
+        if (params.useRotatedBoxes) {
+            //infasuratoarea grupului = infasuratoarea varfurilor fragmentelor din el (nu si a altor
+            //componente care doar cad in dreptunghiul unit)
+            vector<Point> points;
+            for (int k : members[g]) {
+                points.insert(points.end(), hulls[k].begin(), hulls[k].end());
+            }
+            candidate.rotated = minAreaRotatedRect(convexHull(move(points)));
+            area = candidate.rotated.area();
+            aspectRatio = candidate.rotated.aspectRatio();
+        }
+
+        if (area >= params.minPlateArea && area <= params.maxPlateArea &&
+            aspectRatio >= params.aspectRatioMin && aspectRatio <= params.aspectRatioMax) {
+            candidates.push_back(candidate);
         }
     }
+    Metrics::observeCandidates(candidates.size());
     
     return candidates;
 }
 
-MyRect LicensePlateDetector::selectBestPlate(const vector<MyRect>& candidates, const Mat& image) {
+//candidatul e pastrat daca centrul lui cade in masca ROI
+bool LicensePlateDetector::insideRegionOfInterest(const MyRect& rect) const {
+    if (roiMask.empty()) {
+        return true;
+    }
+    int cx = rect.x + rect.width / 2;
+    int cy = rect.y + rect.height / 2;
+    return cx >= 0 && cx < roiMask.cols && cy >= 0 && cy < roiMask.rows && roiMask.at<uchar>(cy, cx) > 0;
+}
+
+static int findRoot(vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+//uneste componentele vecine pe orizontala care au aproximativ aceeasi inaltime
+//baleiere dupa x: se compara doar cu componentele care inca pot fi atinse din stanga
+vector<MyRect> LicensePlateDetector::mergePlateFragments(const vector<MyRect>& components, vector<vector<int>>& members) {
+    int n = (int)components.size();
+    members.clear();
+    if (n < 2) {
+        if (n == 1) {
+            members.push_back({0});
+        }
+        return components;
+    }
+
+    vector<int> order(n);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](int a, int b) { return components[a].x < components[b].x; });
+
+    vector<int> parent(n);
+    iota(parent.begin(), parent.end(), 0);
+
+    vector<int> active;
+    for (int idx : order) {
+        const MyRect& cur = components[idx];
+
+        //scoatem componentele care se termina prea departe in stanga
+        size_t kept = 0;
+        for (int a : active) {
+            const MyRect& r = components[a];
+            if (r.x + r.width + r.height * params.fragmentGapRatio >= cur.x) {
+                active[kept++] = a;
+            }
+        }
+        active.resize(kept);
+
+        for (int a : active) {
+            const MyRect& r = components[a];
+            int minH = min(r.height, cur.height);
+            int maxH = max(r.height, cur.height);
+            int overlapY = min(r.y + r.height, cur.y + cur.height) - max(r.y, cur.y);
+            int gap = cur.x - (r.x + r.width);
+
+            if (maxH <= 2 * minH && overlapY >= 0.6 * minH && gap <= minH * params.fragmentGapRatio) {
+                parent[findRoot(parent, idx)] = findRoot(parent, a);
+            }
+        }
+        active.push_back(idx);
+    }
+
+    vector<int> slot(n, -1);
+    vector<MyRect> merged;
+    for (int i = 0; i < n; i++) {
+        int root = findRoot(parent, i);
+        const MyRect& r = components[i];
+        if (slot[root] < 0) {
+            slot[root] = (int)merged.size();
+            merged.push_back(r);
+            members.push_back({i});
+            continue;
+        }
+        members[slot[root]].push_back(i);
+        MyRect& m = merged[slot[root]];
+        int x2 = max(m.x + m.width, r.x + r.width);
+        int y2 = max(m.y + m.height, r.y + r.height);
+        m.x = min(m.x, r.x);
+        m.y = min(m.y, r.y);
+        m.width = x2 - m.x;
+        m.height = y2 - m.y;
+    }
+
+    return merged;
+}
+
+double LicensePlateDetector::scoreCandidate(const MyRect& rect) {
+    if (!scorer.isBuilt()) {
+        return (double)rect.width * rect.height / params.maxPlateArea;
+    }
+    return scorer.score(rect);
+}
+
+//NMS: sortare dupa x + baleiere cu intervalele active, astfel IoU se calculeaza
+//doar pentru perechile care se suprapun pe orizontala, nu pentru toate n^2 perechi
+vector<PlateCandidate> LicensePlateDetector::suppressOverlaps(const vector<PlateCandidate>& candidates, int maxPlates) {
+    int n = (int)candidates.size();
+    vector<PlateCandidate> result;
+    if (n == 0 || maxPlates <= 0) {
+        return result;
+    }
+
+    vector<int> byX(n);
+    iota(byX.begin(), byX.end(), 0);
+    sort(byX.begin(), byX.end(), [&](int a, int b) { return candidates[a].rect.x < candidates[b].rect.x; });
+
+    vector<vector<int>> overlaps(n);
+    vector<int> active;
+    for (int idx : byX) {
+        const MyRect& cur = candidates[idx].rect;
+
+        size_t kept = 0;
+        for (int a : active) {
+            const MyRect& r = candidates[a].rect;
+            if (r.x + r.width > cur.x) {
+                active[kept++] = a;
+            }
+        }
+        active.resize(kept);
+
+        for (int a : active) {
+            if (candidates[a].rect.iou(cur) > params.nmsOverlapThreshold) {
+                overlaps[a].push_back(idx);
+                overlaps[idx].push_back(a);
+            }
+        }
+        active.push_back(idx);
+    }
+
+    vector<int> byScore(n);
+    iota(byScore.begin(), byScore.end(), 0);
+    stable_sort(byScore.begin(), byScore.end(), [&](int a, int b) { return candidates[a].score > candidates[b].score; });
+
+    vector<bool> suppressed(n, false);
+    for (int idx : byScore) {
+        if (suppressed[idx]) {
+            continue;
+        }
+        result.push_back(candidates[idx]);
+        if ((int)result.size() >= maxPlates) {
+            break;
+        }
+        for (int other : overlaps[idx]) {
+            suppressed[other] = true;
+        }
+    }
+
+    return result;
+}
+
+//din cadrul redus inapoi in cadrul original: pixelul (x, y) acopera blocul [x*f, (x+1)*f)
+MyRect LicensePlateDetector::toFrameCoordinates(const MyRect& rect) const {
+    return MyRect(rect.x * frameScale, rect.y * frameScale, rect.width * frameScale, rect.height * frameScale);
+}
+
+//centrul pixelului x din cadrul redus e centrul blocului lui: x*f + (f-1)/2
+MyRotatedRect LicensePlateDetector::toFrameCoordinates(const MyRotatedRect& rect) const {
+    if (rect.isEmpty() || frameScale == 1) {
+        return rect;
+    }
+    float offset = (frameScale - 1) / 2.0f;
+    return MyRotatedRect(Point2f(rect.center.x * frameScale + offset, rect.center.y * frameScale + offset),
+                         rect.width * frameScale, rect.height * frameScale, rect.angle);
+}
+
+MyRect LicensePlateDetector::selectBestPlate(const vector<PlateCandidate>& candidates, const Mat& image) {
     if (candidates.empty()) {
         return MyRect(0, 0, 0, 0);
     }
 
-    MyRect bestPlate = candidates[0];
-    double maxArea = bestPlate.width * bestPlate.height;
+    //scor din imaginile integrale in loc de aria bruta
+    MyRect bestPlate = candidates[0].rect;
+    double bestScore = scoreCandidate(bestPlate);
     
     for (size_t i = 1; i < candidates.size(); i++) {
-        double area = candidates[i].width * candidates[i].height;
-        if (area > maxArea) {
-            maxArea = area;
-            bestPlate = candidates[i];
+        double score = scoreCandidate(candidates[i].rect);
+        if (score > bestScore) {
+            bestScore = score;
+            bestPlate = candidates[i].rect;
         }
     }
     
@@ -327,8 +1319,8 @@ MyRect LicensePlateDetector::selectBestPlate(const vector<MyRect>& candidates, c
 }
 
 Mat LicensePlateDetector::preprocessPlate(const Mat& plate) {//binarizare adaptiva
-    Mat gray = manualGrayscaleConversion(plate);
-    Mat blurred = manualGaussianBlur(gray, 5);
+    Mat gray = plate.channels() == 1 ? plate : manualGrayscaleConversion(plate);
+    Mat blurred = manualGaussianBlur(gray, params.blurKernelSize);
 
     Mat threshold_img = Mat::zeros(blurred.size(), blurred.type());
     int blockSize = 11; //cati vecini vreau sa iau pentru calc mediei
@@ -357,3 +1349,431 @@ Mat LicensePlateDetector::preprocessPlate(const Mat& plate) {//binarizare adapti
     return threshold_img;
 }
 
+
+//luminanta in virgula fixa pe 8 biti, doar pe decupaj
+static Mat cropLuma(const Mat& image, const Rect& rect) {
+    Mat crop = image(rect);
+    if (crop.channels() == 1) {
+        return crop;
+    }
+    Mat gray(crop.rows, crop.cols, CV_8UC1);
+    for (int i = 0; i < crop.rows; i++) {
+        const uchar* src = crop.ptr<uchar>(i);
+        uchar* dst = gray.ptr<uchar>(i);
+        for (int j = 0; j < crop.cols; j++) {
+            dst[j] = (uchar)((29 * src[3 * j] + 150 * src[3 * j + 1] + 77 * src[3 * j + 2] + 128) >> 8);
+        }
+    }
+    return gray;
+}
+
+//pentru fiecare unghi, muchiile verticale (|I(x+1) - I(x)|, adica trasaturile caracterelor)
+//sunt proiectate pe y' = y - x*tan(unghi), in virgula fixa Q16; la unghiul corect randul de
+//text cade in cat mai putine binuri, deci suma patratelor profilului e maxima.
+//Cautarea ruleaza pe placuta redusa la ~24 px inaltime.
+double LicensePlateDetector::estimatePlateSkew(const Mat& plateGray) {
+    int factor = max(1, plateGray.rows / 24);
+    Mat small = manualAreaDownscale(plateGray, factor);
+    if (small.cols < 3 || small.rows < 3) {
+        return 0.0;
+    }
+
+    Mat gradient(small.rows, small.cols - 1, CV_8UC1);
+    for (int i = 0; i < small.rows; i++) {
+        const uchar* src = small.ptr<uchar>(i);
+        uchar* dst = gradient.ptr<uchar>(i);
+        for (int j = 0; j < gradient.cols; j++) {
+            dst[j] = (uchar)abs((int)src[j + 1] - (int)src[j]);
+        }
+    }
+
+    int centerX = gradient.cols / 2;
+    int maxShift = (int)ceil(centerX * tan(params.maxSkewDegrees * M_PI / 180.0)) + 1;
+    vector<int> profile(gradient.rows + 2 * maxShift + 1);
+    long long bestScore = -1;
+    int bestAngle = 0;
+    for (int angle = -params.maxSkewDegrees; angle <= params.maxSkewDegrees; angle++) {
+        int slope = (int)lround(tan(angle * M_PI / 180.0) * 65536.0);
+        fill(profile.begin(), profile.end(), 0);
+        for (int i = 0; i < gradient.rows; i++) {
+            const uchar* g = gradient.ptr<uchar>(i);
+            for (int j = 0; j < gradient.cols; j++) {
+                int shift = ((j - centerX) * slope) >> 16;
+                profile[i - shift + maxShift] += g[j];
+            }
+        }
+        long long score = 0;
+        for (int value : profile) {
+            score += (long long)value * value;
+        }
+        //la egalitate castiga unghiul mai mic in modul
+        if (score > bestScore || (score == bestScore && abs(angle) < abs(bestAngle))) {
+            bestScore = score;
+            bestAngle = angle;
+        }
+    }
+    return bestAngle;
+}
+
+//interpolare biliniara pentru un rand de iesire: coordonatele sursa in Q16 avanseaza liniar,
+//ponderile au 7 biti. Cu SSE2, cate 8 pixeli: vecinii se citesc scalar, iar ponderarea se face
+//cu _mm_madd_epi16 pe perechi (stanga, dreapta), apoi (sus, jos).
+static void bilinearRow(const Mat& src, int x, int y, int dx, int dy, uchar* dst, int count) {
+    int maxX = src.cols - 2;
+    int maxY = src.rows - 2;
+    auto sample = [&](int sx, int sy, int& p00, int& p01, int& p10, int& p11, int& fx, int& fy) {
+        int ix = sx >> 16, iy = sy >> 16;
+        fx = (sx >> 9) & 127;
+        fy = (sy >> 9) & 127;
+        if (ix < 0) { ix = 0; fx = 0; } else if (ix > maxX) { ix = maxX; fx = 128; }
+        if (iy < 0) { iy = 0; fy = 0; } else if (iy > maxY) { iy = maxY; fy = 128; }
+        const uchar* row0 = src.ptr<uchar>(iy) + ix;
+        const uchar* row1 = src.ptr<uchar>(iy + 1) + ix;
+        p00 = row0[0];
+        p01 = row0[1];
+        p10 = row1[0];
+        p11 = row1[1];
+    };
+
+    int u = 0;
+#if defined(LPR_SSE2)
+    alignas(16) short a[8], b[8], c[8], d[8], wx[8], wy[8];
+    const __m128i weightOne = _mm_set1_epi16(128);
+    const __m128i rounding = _mm_set1_epi32(1 << 13);
+    for (; u + 8 <= count; u += 8) {
+        for (int k = 0; k < 8; k++) {
+            int p00, p01, p10, p11, fx, fy;
+            sample(x + (u + k) * dx, y + (u + k) * dy, p00, p01, p10, p11, fx, fy);
+            a[k] = (short)p00;
+            b[k] = (short)p01;
+            c[k] = (short)p10;
+            d[k] = (short)p11;
+            wx[k] = (short)fx;
+            wy[k] = (short)fy;
+        }
+        __m128i fx = _mm_load_si128((const __m128i*)wx);
+        __m128i fy = _mm_load_si128((const __m128i*)wy);
+        __m128i ax = _mm_sub_epi16(weightOne, fx);
+        __m128i ay = _mm_sub_epi16(weightOne, fy);
+        __m128i left = _mm_load_si128((const __m128i*)a);
+        __m128i right = _mm_load_si128((const __m128i*)b);
+        __m128i leftBottom = _mm_load_si128((const __m128i*)c);
+        __m128i rightBottom = _mm_load_si128((const __m128i*)d);
+
+        //p*(128-fx) + q*fx <= 255*128, incape in int16
+        __m128i top = _mm_packs_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi16(left, right), _mm_unpacklo_epi16(ax, fx)),
+            _mm_madd_epi16(_mm_unpackhi_epi16(left, right), _mm_unpackhi_epi16(ax, fx)));
+        __m128i bottom = _mm_packs_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi16(leftBottom, rightBottom), _mm_unpacklo_epi16(ax, fx)),
+            _mm_madd_epi16(_mm_unpackhi_epi16(leftBottom, rightBottom), _mm_unpackhi_epi16(ax, fx)));
+        __m128i lo = _mm_srai_epi32(_mm_add_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi16(top, bottom), _mm_unpacklo_epi16(ay, fy)), rounding), 14);
+        __m128i hi = _mm_srai_epi32(_mm_add_epi32(
+            _mm_madd_epi16(_mm_unpackhi_epi16(top, bottom), _mm_unpackhi_epi16(ay, fy)), rounding), 14);
+        __m128i packed = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64((__m128i*)(dst + u), _mm_packus_epi16(packed, packed));
+    }
+#endif
+    for (; u < count; u++) {
+        int p00, p01, p10, p11, fx, fy;
+        sample(x + u * dx, y + u * dy, p00, p01, p10, p11, fx, fy);
+        int top = p00 * (128 - fx) + p01 * fx;
+        int bottom = p10 * (128 - fx) + p11 * fx;
+        dst[u] = (uchar)((top * (128 - fy) + bottom * fy + (1 << 13)) >> 14);
+    }
+}
+
+//dreptunghiul aliniat al unei placute de lungime L si inaltime h rotite cu t are
+//W = L cos t + h sin t si H = L sin t + h cos t; de aici L si h, apoi esantionare pe axele rotite
+Mat LicensePlateDetector::rectifyPlate(const Mat& image, const MyRect& rect) {
+    Rect bounds = Rect(rect.x, rect.y, rect.width, rect.height) & Rect(0, 0, image.cols, image.rows);
+    if (bounds.width < 2 || bounds.height < 2) {
+        return Mat();
+    }
+    Mat gray = cropLuma(image, bounds);
+    double skew = estimatePlateSkew(gray);
+
+    double radians = skew * M_PI / 180.0;
+    double cosT = cos(radians), sinT = sin(radians);
+    double denominator = cosT * cosT - sinT * sinT;
+    double length = (bounds.width * cosT - bounds.height * fabs(sinT)) / denominator;
+    double height = (bounds.height * cosT - bounds.width * fabs(sinT)) / denominator;
+    if (length <= 0 || height < bounds.height * 0.25) {
+        //dreptunghi prea strans pentru unghiul gasit: doar rotim in jurul centrului
+        length = bounds.width;
+        height = bounds.height;
+    }
+
+    int outWidth = params.rectifiedWidth;
+    int outHeight = params.rectifiedHeight;
+    Mat rectified(outHeight, outWidth, CV_8UC1);
+    double centerX = (bounds.width - 1) / 2.0;
+    double centerY = (bounds.height - 1) / 2.0;
+    double stepU = length / outWidth;
+    double stepV = height / outHeight;
+    int dx = (int)lround(stepU * cosT * 65536.0);
+    int dy = (int)lround(stepU * sinT * 65536.0);
+    for (int v = 0; v < outHeight; v++) {
+        //centrul primului pixel din rand, in coordonatele decupajului
+        double du = 0.5 * stepU - length / 2;
+        double dv = (v + 0.5) * stepV - height / 2;
+        double x = centerX + du * cosT - dv * sinT;
+        double y = centerY + du * sinT + dv * cosT;
+        bilinearRow(gray, (int)lround(x * 65536.0), (int)lround(y * 65536.0), dx, dy, rectified.ptr<uchar>(v), outWidth);
+    }
+    return rectified;
+}
+
+//pixelii albi pe fiecare coloana, adunati rand cu rand; binarul e 0/255, deci min(v, 1)
+//e 0/1 si se aduna pe 16 biti, cate 16 coloane deodata
+static void accumulateColumns(const uchar* row, ushort* sums, int n) {
+    int j = 0;
+#if defined(LPR_SSE2)
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i zero = _mm_setzero_si128();
+    for (; j + 16 <= n; j += 16) {
+        __m128i bits = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(row + j)), one);
+        __m128i lo = _mm_loadu_si128((const __m128i*)(sums + j));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(sums + j + 8));
+        _mm_storeu_si128((__m128i*)(sums + j), _mm_add_epi16(lo, _mm_unpacklo_epi8(bits, zero)));
+        _mm_storeu_si128((__m128i*)(sums + j + 8), _mm_add_epi16(hi, _mm_unpackhi_epi8(bits, zero)));
+    }
+#elif defined(LPR_NEON)
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; j + 16 <= n; j += 16) {
+        uint8x16_t bits = vminq_u8(vld1q_u8(row + j), one);
+        vst1q_u16(sums + j, vaddw_u8(vld1q_u16(sums + j), vget_low_u8(bits)));
+        vst1q_u16(sums + j + 8, vaddw_u8(vld1q_u16(sums + j + 8), vget_high_u8(bits)));
+    }
+#endif
+    for (; j < n; j++) {
+        sums[j] += row[j] != 0;
+    }
+}
+
+//segment alb [start, end) pe un rand, cu eticheta componentei
+struct PixelRun {
+    int start, end;
+    int label;
+};
+
+//statistici pe componenta, adunate din segmente
+struct RunComponent {
+    int minX, minY, maxX, maxY;
+    int pixels;
+};
+
+static double medianOf(vector<int> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t mid = values.size() / 2;
+    nth_element(values.begin(), values.begin() + mid, values.end());
+    return values[mid];
+}
+
+//taie un dreptunghi prea lat (caractere lipite) in minimul profilului de coloane, recursiv
+static void splitOnProfile(const MyRect& box, const vector<ushort>& profile, int maxWidth, int minWidth,
+                           vector<MyRect>& out) {
+    if (box.width <= maxWidth || box.width < 2 * minWidth) {
+        out.push_back(box);
+        return;
+    }
+    int cut = box.x + minWidth;
+    for (int j = box.x + minWidth; j <= box.x + box.width - minWidth; j++) {
+        if (profile[j] < profile[cut]) {
+            cut = j;
+        }
+    }
+    splitOnProfile(MyRect(box.x, box.y, cut - box.x, box.height), profile, maxWidth, minWidth, out);
+    splitOnProfile(MyRect(cut, box.y, box.x + box.width - cut, box.height), profile, maxWidth, minWidth, out);
+}
+
+//o singura trecere peste decupaj: profilul vertical (suma pe coloane, SIMD) si segmentele
+//albe ale fiecarui rand, unite cu segmentele atinse (8-conectivitate) de pe randul anterior
+//printr-un union-find; statisticile se tin doar la radacini. Componentele sunt filtrate dupa
+//inaltime, apoi dupa consistenta inaltimii si a liniei de baza fata de mediane; cele prea
+//late (caractere lipite) sunt taiate pe profil.
+vector<MyRect> LicensePlateDetector::segmentCharacters(const Mat& binaryPlate) {
+    StageTimer timer(STAGE_SEGMENTATION);
+    vector<MyRect> characters;
+    if (binaryPlate.empty() || binaryPlate.channels() != 1) {
+        return characters;
+    }
+
+    vector<ushort> profile(binaryPlate.cols, 0);
+    vector<int> parent;
+    vector<RunComponent> components;
+    vector<PixelRun> previous, current;
+    for (int i = 0; i < binaryPlate.rows; i++) {
+        const uchar* row = binaryPlate.ptr<uchar>(i);
+        accumulateColumns(row, profile.data(), binaryPlate.cols);
+
+        current.clear();
+        size_t k = 0;
+        for (int j = 0; j < binaryPlate.cols;) {
+            if (row[j] == 0) {
+                j++;
+                continue;
+            }
+            int start = j;
+            while (j < binaryPlate.cols && row[j] != 0) {
+                j++;
+            }
+            //segmentele de sus care ating [start - 1, j], inclusiv pe diagonala
+            while (k < previous.size() && previous[k].end < start) {
+                k++;
+            }
+            int label = -1;
+            for (size_t p = k; p < previous.size() && previous[p].start <= j; p++) {
+                int root = findRoot(parent, previous[p].label);
+                if (label < 0) {
+                    label = root;
+                } else if (root != label) {
+                    parent[root] = label;
+                    RunComponent& into = components[label];
+                    const RunComponent& from = components[root];
+                    into.minX = min(into.minX, from.minX);
+                    into.minY = min(into.minY, from.minY);
+                    into.maxX = max(into.maxX, from.maxX);
+                    into.maxY = max(into.maxY, from.maxY);
+                    into.pixels += from.pixels;
+                }
+            }
+            if (label < 0) {
+                label = (int)parent.size();
+                parent.push_back(label);
+                components.push_back(RunComponent{start, i, j - 1, i, 0});
+            }
+            RunComponent& component = components[label];
+            component.minX = min(component.minX, start);
+            component.maxX = max(component.maxX, j - 1);
+            component.maxY = i;
+            component.pixels += j - start;
+            current.push_back(PixelRun{start, j, label});
+        }
+        previous.swap(current);
+    }
+
+    //componente de inaltimea unui caracter, nici bare pline (rama), nici puncte
+    int plateHeight = binaryPlate.rows;
+    vector<MyRect> boxes;
+    for (size_t c = 0; c < parent.size(); c++) {
+        if (parent[c] != (int)c) {
+            continue;
+        }
+        const RunComponent& component = components[c];
+        MyRect box(component.minX, component.minY, component.maxX - component.minX + 1,
+                   component.maxY - component.minY + 1);
+        double fill = (double)component.pixels / (box.width * box.height);
+        if (box.height >= params.charMinHeightFraction * plateHeight &&
+            box.height <= params.charMaxHeightFraction * plateHeight && fill > 0.1 && fill < 0.95) {
+            boxes.push_back(box);
+        }
+    }
+    if (boxes.empty()) {
+        return characters;
+    }
+
+    vector<int> heights, baselines;
+    for (const auto& box : boxes) {
+        heights.push_back(box.height);
+        baselines.push_back(box.y + box.height);
+    }
+    double medianHeight = medianOf(heights);
+    double medianBaseline = medianOf(baselines);
+    int maxWidth = max(1, (int)(params.charMaxAspect * medianHeight));
+    int minWidth = max(1, (int)(0.25 * medianHeight));
+    for (const auto& box : boxes) {
+        if (fabs(box.height - medianHeight) > params.charHeightTolerance * medianHeight ||
+            fabs(box.y + box.height - medianBaseline) > params.charBaselineTolerance * medianHeight) {
+            continue;
+        }
+        splitOnProfile(box, profile, maxWidth, minWidth, characters);
+    }
+
+    sort(characters.begin(), characters.end(), [](const MyRect& a, const MyRect& b) {
+        return a.x < b.x;
+    });
+    return characters;
+}
+
+//suma pe dreptunghiul [0,i) x [0,j), cu un rand si o coloana de zero in plus
+static Mat integralOf(const Mat& image, int divisor) {
+    Mat integral = Mat::zeros(image.rows + 1, image.cols + 1, CV_64F);
+
+    for (int i = 0; i < image.rows; i++) {
+        const uchar* src = image.ptr<uchar>(i);
+        const double* above = integral.ptr<double>(i);
+        double* dst = integral.ptr<double>(i + 1);
+        double rowSum = 0;
+        for (int j = 0; j < image.cols; j++) {
+            rowSum += src[j] / divisor;
+            dst[j + 1] = above[j + 1] + rowSum;
+        }
+    }
+
+    return integral;
+}
+
+void CandidateScorer::build(const Mat& edges, const Mat& binary, Point _origin) {
+    origin = _origin;
+
+    //harta de tranzitii: 1 unde pixelul binar difera de vecinul din stanga
+    Mat transitions = Mat::zeros(binary.size(), CV_8UC1);
+    for (int i = 0; i < binary.rows; i++) {
+        const uchar* src = binary.ptr<uchar>(i);
+        uchar* dst = transitions.ptr<uchar>(i);
+        for (int j = 1; j < binary.cols; j++) {
+            dst[j] = src[j] != src[j - 1];
+        }
+    }
+
+    edgeSum = integralOf(edges, 1);
+    binarySum = integralOf(binary, 255);
+    transitionSum = integralOf(transitions, 1);
+}
+
+double CandidateScorer::boxSum(const Mat& integral, const MyRect& rect) const {
+    int x1 = max(0, rect.x - origin.x);
+    int y1 = max(0, rect.y - origin.y);
+    int x2 = min(integral.cols - 1, rect.x - origin.x + rect.width);
+    int y2 = min(integral.rows - 1, rect.y - origin.y + rect.height);
+    if (x2 <= x1 || y2 <= y1) {
+        return 0.0;
+    }
+    return integral.at<double>(y2, x2) - integral.at<double>(y1, x2)
+         - integral.at<double>(y2, x1) + integral.at<double>(y1, x1);
+}
+
+double CandidateScorer::edgeDensity(const MyRect& rect) const {
+    if (rect.isEmpty()) {
+        return 0.0;
+    }
+    return boxSum(edgeSum, rect) / (255.0 * rect.width * rect.height);
+}
+
+double CandidateScorer::transitionsPerRow(const MyRect& rect) const {
+    if (rect.isEmpty()) {
+        return 0.0;
+    }
+    return boxSum(transitionSum, rect) / rect.height;
+}
+
+double CandidateScorer::fillRatio(const MyRect& rect) const {
+    if (rect.isEmpty()) {
+        return 0.0;
+    }
+    return boxSum(binarySum, rect) / ((double)rect.width * rect.height);
+}
+
+//o placuta are multe muchii verticale (caracterele), cel putin ~2 tranzitii
+//pe caracter pe fiecare rand si nu e nici goala, nici complet alba
+double CandidateScorer::score(const MyRect& rect) const {
+    double density = min(edgeDensity(rect) * 4.0, 1.0);
+    double transitions = min(transitionsPerRow(rect) / 12.0, 1.0);
+    double fill = max(0.0, 1.0 - fabs(fillRatio(rect) - 0.4) / 0.6);
+
+    return 0.4 * transitions + 0.3 * density + 0.3 * fill;
+}
@@ -15,32 +15,260 @@ public:
     bool isEmpty() const {
         return width <= 0 || height <= 0;
     }
+
+    //intersectia / reuniunea; 0 daca nu se suprapun (NMS, tracker, tuner)
+    double iou(const MyRect& other) const {
+        int x1 = max(x, other.x);
+        int y1 = max(y, other.y);
+        int x2 = min(x + width, other.x + other.width);
+        int y2 = min(y + height, other.y + other.height);
+        if (x2 <= x1 || y2 <= y1) {
+            return 0.0;
+        }
+        double intersection = (double)(x2 - x1) * (y2 - y1);
+        return intersection / ((double)width * height + (double)other.width * other.height - intersection);
+    }
+};
+
+//dreptunghi rotit (de arie minima in jurul unei componente); width e mereu latura lunga
+class MyRotatedRect {
+public:
+    Point2f center;
+    float width, height;
+    float angle; //grade, directia laturii lungi fata de axa x, in (-90, 90]
+
+    MyRotatedRect() : center(0, 0), width(0), height(0), angle(0) {}
+    MyRotatedRect(Point2f _center, float _width, float _height, float _angle)
+        : center(_center), width(_width), height(_height), angle(_angle) {}
+
+    bool isEmpty() const {
+        return width <= 0 || height <= 0;
+    }
+    double area() const { return (double)width * height; }
+    double aspectRatio() const { return height > 0 ? (double)width / height : 0.0; }
+    void corners(Point2f out[4]) const;
+    MyRect boundingRect() const;
+};
+
+//formatul cadrelor primite direct de la camera / decodor
+enum class FrameFormat {
+    BGR,  //3 canale intercalate, ca imread
+    GRAY, //un singur plan de luminanta
+    NV12, //plan Y urmat de UV intercalat
+    I420  //plan Y urmat de planele U si V
+};
+
+//rezultat pentru detectia multipla: dreptunghiul si scorul lui
+class PlateCandidate {
+public:
+    MyRect rect;
+    double score;
+    MyRotatedRect rotated; //gol daca useRotatedBoxes e dezactivat
+
+    PlateCandidate() : rect(), score(0.0) {}
+    PlateCandidate(const MyRect& _rect, double _score) : rect(_rect), score(_score) {}
+};
+
+//contur extras prin urmarirea marginii (Suzuki-Abe), codificat Freeman: punctul de start si,
+//pentru fiecare pas, directia spre urmatorul pixel de margine (0 = E, 2 = N, 4 = V, 6 = S).
+//Memoria e proportionala cu perimetrul, nu cu aria.
+class ChainContour {
+public:
+    Point start;
+    vector<uchar> codes;
+    bool isHole; //marginea unei gauri; altfel marginea exterioara a unei componente
+    int parent; //indexul conturului parinte, -1 = nivelul de sus
+    MyRect bounds;
+
+    ChainContour() : start(0, 0), isHole(false), parent(-1) {}
+
+    static Point step(int code);
+    vector<Point> points() const;
+    double area() const; //aria poligonului prin pixelii de margine (formula lui Gauss)
+    double pixelCount() const; //pixelii componentei, prin teorema lui Pick (gaurile incluse)
+};
+
+//toti parametrii detectorului intr-un singur loc, ca sa poata fi reglati per camera
+//(vezi tuner.cpp); valorile implicite sunt cele folosite pana acum
+struct DetectorParams {
+    double aspectRatioMin = 2.0; //val min de raport de aspect(width/height) ->pentru forma
+    double aspectRatioMax = 6.0;
+    double minPlateArea = 1000; //verifica dimensiunea unei placute
+    double maxPlateArea = 30000;
+
+    int blurKernelSize = 5;
+    int morphWidth = 17; //elementul structurant conecteaza componentele orizontale
+    int morphHeight = 3;
+    int minContourPixels = 50; //componentele mai mici sunt zgomot
+
+    //regulile de selectie din main/test/tuner (detectLargestContour): forma alungita si pozitionata jos
+    double selectionAspectMin = 2.5;
+    double roiTopFraction = 0.4;
+
+    //filtrele de arie si aspect folosesc dreptunghiul rotit de arie minima in locul celui
+    //aliniat la axe, ca placutele inclinate (camere laterale) sa nu fie respinse
+    bool useRotatedBoxes = true;
+
+    double nmsOverlapThreshold = 0.3; //IoU peste care doua candidate sunt aceeasi placuta
+    double fragmentGapRatio = 0.6; //distanta maxima intre fragmente, relativ la inaltime
+
+    //cadrele mai late de 2 x canonicalWidth sunt reduse cu un factor intreg inainte de detectie,
+    //ca pragurile de arie si elementul morfologic sa fie valabile la orice rezolutie; 0 = dezactivat
+    int canonicalWidth = 640;
+
+    //indreptarea placutei inainte de preprocessPlate (rectifyPlate)
+    int rectifiedWidth = 260;
+    int rectifiedHeight = 56;
+    int maxSkewDegrees = 15; //unghiurile cautate: -max..max, din grad in grad
+
+    //segmentarea caracterelor pe placuta binarizata, relativ la inaltimea placutei
+    double charMinHeightFraction = 0.3;
+    double charMaxHeightFraction = 0.95;
+    double charMaxAspect = 0.9; //latime / inaltime; mai lat = caractere lipite, taiate pe profil
+    double charHeightTolerance = 0.25; //abaterea maxima fata de mediana inaltimilor
+    double charBaselineTolerance = 0.15; //abaterea maxima a bazei fata de mediana, relativ la inaltime
+
+    bool useTileCascade = true;
+    int tileSize = 32;
+    double tileMinEnergy = 4.0; //media |gx| minima pe tile
+    int tileMinTransitions = 4; //tranzitii orizontale minime in binar pe tile
+};
+
+//statistici cumulate de la construirea detectorului (sau ultimul resetStats)
+class DetectionStats {
+public:
+    long long framesProcessed;
+    long long tilesTotal;
+    long long tilesRejected; //tile-uri eliminate de cascada inainte de morfologie
+
+    DetectionStats() : framesProcessed(0), tilesTotal(0), tilesRejected(0) {}
+
+    double tileRejectionRate() const {
+        return tilesTotal > 0 ? (double)tilesRejected / tilesTotal : 0.0;
+    }
 };
 
+//imagini integrale ale hartilor de muchii/binare, construite o data pe cadru,
+//ca sa putem scora orice dreptunghi candidat in O(1)
+class CandidateScorer {
+public:
+    //origin: coltul hartilor in cadrul intreg, cand se proceseaza doar un ROI
+    void build(const Mat& edges, const Mat& binary, Point origin = Point(0, 0));
+    bool isBuilt() const { return !edgeSum.empty(); }
+
+    double edgeDensity(const MyRect& rect) const; //media |gx| / 255
+    double transitionsPerRow(const MyRect& rect) const; //treceri alb-negru pe rand
+    double fillRatio(const MyRect& rect) const; //procent de pixeli albi in binar
+    double score(const MyRect& rect) const;
+
+private:
+    double boxSum(const Mat& integral, const MyRect& rect) const;
+
+    Mat edgeSum; //CV_64F, (rows+1) x (cols+1)
+    Mat binarySum;
+    Mat transitionSum;
+    Point origin;
+};
+
+class StageCache;
+
 class LicensePlateDetector {
 public:
     LicensePlateDetector();
+    explicit LicensePlateDetector(const DetectorParams& params);
+
+    const DetectorParams& getParams() const { return params; }
+    void setParams(const DetectorParams& _params) { params = _params; }
 
     MyRect detectLicensePlate(const Mat& image);
+    //primele maxPlates placute, ordonate descrescator dupa scor
+    vector<PlateCandidate> detectLicensePlates(const Mat& image, int maxPlates);
+    //selectia din test.cpp: cel mai mare contur exterior mai lat de selectionAspectMin ori inaltimea,
+    //sub roiTopFraction din cadru (ROI-ul e setat aici si sters la final)
+    MyRect detectLargestContour(const Mat& image);
+
+    //cadre brute: pentru YUV/GRAY planul Y e folosit direct ca imagine gri (fara conversie, fara copiere)
+    //stride = 0 -> randuri compacte
+    MyRect detectLicensePlate(const uchar* data, int width, int height, FrameFormat format, size_t stride = 0);
+    vector<PlateCandidate> detectLicensePlates(const uchar* data, int width, int height, FrameFormat format,
+                                               int maxPlates, size_t stride = 0);
+    static Mat wrapFrame(const uchar* data, int width, int height, FrameFormat format, size_t stride = 0);
 
     Mat preprocessPlate(const Mat& plate);
+    //decupajul placutei din cadru, indreptat si adus la rectifiedWidth x rectifiedHeight (gri)
+    Mat rectifyPlate(const Mat& image, const MyRect& rect);
+    //inclinarea textului in grade (pozitiv = coboara spre dreapta), din profilul de proiectie
+    double estimatePlateSkew(const Mat& plateGray);
+    //dreptunghiurile caracterelor de pe placuta binarizata (preprocessPlate), de la stanga la dreapta
+    vector<MyRect> segmentCharacters(const Mat& binaryPlate);
+
+    //media pe blocuri factor x factor (aritmetica intreaga, SIMD pe sumele verticale)
+    static Mat manualAreaDownscale(const Mat& image, int factor);
+    //luminanta redusa cu un factor intreg pana la cel putin minWidth (portile de miscare/calitate)
+    static Mat decimatedLuma(const Mat& frame, int minWidth);
+    int normalizationFactor(int frameWidth) const;
+    static int normalizationFactor(int frameWidth, int canonicalWidth);
 
     Mat manualGrayscaleConversion(const Mat& image);
     Mat manualGaussianBlur(const Mat& image, int kernelSize);
     Mat manualSobelOperator(const Mat& image);
     Mat manualThreshold(const Mat& image, int threshold);
     Mat manualMorphologicalOperation(const Mat& image);
+    Mat manualMorphologicalOperation(const Mat& image, const Mat& activeTiles);
     vector<vector<Point>> manualFindContours(const Mat& image);
+    vector<vector<Point>> manualFindContours(const Mat& image, const Mat& activeTiles);
+    //urmarire de margine Suzuki-Abe, 8-conectivitate; contururile exterioare si gaurile, cu ierarhie
+    vector<ChainContour> manualTraceContours(const Mat& image);
+    //infasuratoarea convexa (Andrew, O(n log n)) si dreptunghiul de arie minima (rotating calipers)
+    static vector<Point> convexHull(vector<Point> points);
+    static MyRotatedRect minAreaRotatedRect(const vector<Point>& hull);
+    Mat findActiveTiles(const Mat& edges, const Mat& binary);
+
+    //ROI static per camera, in coordonatele cadrului; rezultatele raman in coordonate de cadru
+    void setRegionOfInterest(const vector<Rect>& rects);
+    void setRegionOfInterest(const vector<Point>& polygon);
+    void clearRegionOfInterest();
+    //scale > 1: dreptunghiul in coordonatele cadrului redus de scale ori
+    Rect regionOfInterestCrop(Size frameSize, int scale = 1);
+
+    //cache optional pentru etapele timpurii (nu e detinut de detector; poate fi partajat intre thread-uri)
+    void setStageCache(StageCache* cache) { stageCache = cache; }
+
+    //ferestrele imshow cu etapele intermediare (implicit pornite)
+    void setDebugWindows(bool enabled) { showDebugWindows = enabled; }
+
+    const DetectionStats& getStats() const { return stats; }
+    void resetStats() { stats = DetectionStats(); }
 
 private:
     Mat preprocessImage(const Mat& image);
-    vector<MyRect> findPossiblePlateRegions(const Mat& image);
-    MyRect selectBestPlate(const vector<MyRect>& candidates, const Mat& image);
+    void computeEdgeMaps(const Mat& view, Mat& gray, Mat& blurred, Mat& edges, Mat& binary);
+    vector<PlateCandidate> findPossiblePlateRegions(const Mat& image);
+    MyRect selectBestPlate(const vector<PlateCandidate>& candidates, const Mat& image);
+    const Mat& regionOfInterestMask(Size frameSize, int scale);
+    Mat restrictTilesToMask(const Mat& tiles, const Mat& mask);
+    bool insideRegionOfInterest(const MyRect& rect) const;
+    //members[g] = indicii componentelor din grupul g
+    vector<MyRect> mergePlateFragments(const vector<MyRect>& components, vector<vector<int>>& members);
+    double scoreCandidate(const MyRect& rect);
+    vector<PlateCandidate> suppressOverlaps(const vector<PlateCandidate>& candidates, int maxPlates);
+    MyRect toFrameCoordinates(const MyRect& rect) const;
+    MyRotatedRect toFrameCoordinates(const MyRotatedRect& rect) const;
+
+    DetectorParams params;
+    bool showDebugWindows;
+    StageCache* stageCache;
+
+    CandidateScorer scorer; //reconstruit in preprocessImage pentru fiecare cadru
+    Mat activeTiles; //masca de tile-uri a cadrului curent, goala = toata imaginea
+    DetectionStats stats;
 
-    double aspectRatioMin; //val min de raport de aspect(width/height) ->pentru forma
-    double aspectRatioMax;
-    double minPlateArea;//verifica dimensiunea unei placute
-    double maxPlateArea;
+    vector<Rect> roiRects;
+    vector<Point> roiPolygon;
+    Mat roiMask; //CV_8UC1 pe tot cadrul (redus), goala = fara ROI
+    int roiMaskScale;
+    Rect frameCrop; //zona procesata din cadrul curent, in coordonatele cadrului redus
+    int frameScale; //factorul de reducere al cadrului curent (1 = rezolutia originala)
 };
 
 #endif
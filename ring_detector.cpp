@@ -0,0 +1,293 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "frame_ring.h"
+#include "frame_scheduler.h"
+#include "motion_gate.h"
+#include "frame_quality.h"
+#include "plate_tracker.h"
+#include "async_writer.h"
+#include "metrics.h"
+#include "tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+//Ctrl-C / SIGTERM opresc bucla ca la sentinela, deci writer-ul inchide jurnalele normal
+static std::atomic<bool> stopRequested{false};
+
+static void requestStop(int) {
+    stopRequested = true;
+}
+
+//acelasi ceas monoton ca captureNs al producatorului; system_clock poate sari (NTP, ajustari
+//manuale) si ar strica varsta cadrelor, deci bugetul si termenele planificatorului
+static int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+//latenta pe bucket-uri de 1 ms, ultimul = peste LATENCY_HISTOGRAM_MS: memorie fixa oricat ar rula
+//consumatorul; percentila e limita de sus a bucket-ului in care cade
+const int LATENCY_HISTOGRAM_MS = 1000;
+
+static std::string latencyPercentile(const std::vector<long long>& histogram, long long rank) {
+    long long seen = 0;
+    for (int b = 0; b < LATENCY_HISTOGRAM_MS; b++) {
+        seen += histogram[b];
+        if (seen > rank) {
+            return "<= " + std::to_string(b + 1) + " ms";
+        }
+    }
+    return "> " + std::to_string(LATENCY_HISTOGRAM_MS) + " ms";
+}
+
+//consumator: citeste cadrele din inel pe loc (Mat peste memoria partajata) si ruleaza detectia
+int main(int argc, char** argv) {
+    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
+
+    std::string name = "/lpr_frames";
+    bool detect = true;
+    int maxPlates = 3;
+    std::string tracePath;
+    double deadlineMs = 0; //0 = fiecare cadru la calitate completa, in ordine FIFO
+    bool motionGate = false;
+    bool runOcr = false;
+    //skip: cadrele neclare/prost expuse sunt sarite; defer: rulate doar cand nu asteapta alte cadre
+    std::string qualityGate = "0";
+    //iesirile (decupaje, linii JSON) merg prin writer-ul asincron, niciodata direct pe disc
+    std::string archiveDir;
+    std::string resultsPath;
+    std::string fsyncPolicy = "interval";
+    std::string detectionLogPath;
+    uint32_t cameraId = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--name") name = value;
+        else if (key == "--detect") detect = value != "0";
+        else if (key == "--max-plates") maxPlates = std::stoi(value);
+        else if (key == "--trace") tracePath = value;
+        else if (key == "--deadline-ms") deadlineMs = std::stod(value);
+        else if (key == "--motion-gate") motionGate = value != "0";
+        else if (key == "--ocr") runOcr = value != "0";
+        else if (key == "--quality-gate") qualityGate = value;
+        else if (key == "--archive") archiveDir = value;
+        else if (key == "--results") resultsPath = value;
+        else if (key == "--fsync") fsyncPolicy = value;
+        else if (key == "--detection-log") detectionLogPath = value;
+        else if (key == "--camera-id") cameraId = (uint32_t)std::stoul(value);
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+
+    FrameRing ring;
+    while (!ring.open(name)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    LicensePlateDetector detector;
+    detector.setDebugWindows(false);
+
+    Tracer::setEnabled(!tracePath.empty());
+    Tracer::setThreadName("ring consumer");
+
+    SchedulerConfig schedulerConfig;
+    schedulerConfig.deadlineMs = deadlineMs;
+    schedulerConfig.maxPlates = maxPlates;
+    FrameScheduler scheduler(detector, schedulerConfig);
+    long long decisions[4] = {};
+
+    //fara miscare se refolosesc placutele de la ultima detectie
+    MotionGate gate;
+    std::vector<PlateCandidate> lastPlates;
+    long long idleFrames = 0;
+
+    FrameQualityGate quality;
+    bool useQualityGate = qualityGate == "skip" || qualityGate == "defer";
+    long long qualitySkipped = 0;
+
+    std::unique_ptr<AsyncWriter> writer;
+    if (!archiveDir.empty() || !resultsPath.empty() || !detectionLogPath.empty()) {
+        AsyncWriterConfig writerConfig;
+        writerConfig.writeCrops = !archiveDir.empty();
+        writerConfig.archive.directory = archiveDir;
+        writerConfig.resultsPath = resultsPath;
+        writerConfig.detectionLogPath = detectionLogPath;
+        if (fsyncPolicy == "never") writerConfig.fsync = FsyncPolicy::NEVER;
+        else if (fsyncPolicy == "batch") writerConfig.fsync = FsyncPolicy::PER_BATCH;
+        else writerConfig.fsync = FsyncPolicy::INTERVAL;
+        writer = std::make_unique<AsyncWriter>(writerConfig);
+    }
+
+    //un eveniment cu textul final pentru fiecare vehicul
+    PlateTracker tracker(detector, TrackerConfig());
+    long long vehicles = 0;
+    auto report = [&](const std::vector<PlateEvent>& events) {
+        for (const auto& event : events) {
+            vehicles++;
+            std::cout << "Vehicle " << event.trackId << ": " << event.text << " (confidence " << event.confidence
+                      << ", frames " << event.firstFrame << "-" << event.lastFrame << ", OCR runs " << event.ocrRuns
+                      << ")" << std::endl;
+            if (writer) {
+                writer->submitLine("{\"vehicle\":" + std::to_string(event.trackId) + ",\"text\":\"" + event.text +
+                                   "\",\"confidence\":" + std::to_string(event.confidence) + ",\"first_frame\":" +
+                                   std::to_string(event.firstFrame) + ",\"last_frame\":" +
+                                   std::to_string(event.lastFrame) + "}");
+            }
+        }
+    };
+
+    long long frames = 0;
+    long long plates = 0;
+    double pickupMs = 0; //cat a stat cadrul in inel pana a fost preluat
+    std::vector<long long> latencyHistogram(LATENCY_HISTOGRAM_MS + 1, 0); //de la captura pana la rezultat
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    Clock::time_point start = Clock::now();
+    while (!stopRequested) {
+        const FrameHeader* frame = nullptr;
+        const uchar* data = nullptr;
+        if (!ring.beginRead(frame, data)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (frame->width == 0) {
+            ring.endRead();
+            break;
+        }
+
+        int64_t now = monotonicNs();
+        double ageMs = (now - frame->captureNs) / 1e6;
+        pickupMs += ageMs;
+
+        TraceSpan span("frame");
+        if (detect) {
+            Mat image = FrameRing::frameView(*frame, data);
+            bool rejected = false;
+            uint64_t stagesBefore[STAGE_COUNT];
+            Metrics::stageTotals(stagesBefore);
+            if (motionGate && !gate.update(image)) {
+                idleFrames++;
+                Metrics::increment(COUNTER_MOTION_IDLE_FRAMES);
+            } else if (useQualityGate && !quality.evaluate(image).acceptable &&
+                       !(qualityGate == "defer" && ring.pending() <= 1)) {
+                //defer: un cadru slab e rulat totusi daca nu asteapta nimic in spatele lui
+                qualitySkipped++;
+                rejected = true;
+            } else {
+                //regiunile in miscare devin ROI-ul (gol = tot cadrul, de ex. la primul cadru)
+                if (motionGate && !gate.movingRegions().empty()) {
+                    detector.setRegionOfInterest(gate.movingRegions());
+                }
+                if (deadlineMs > 0) {
+                    //pending() include si cadrul curent, inca neeliberat
+                    size_t backlog = (size_t)ring.pending() - 1;
+                    FrameDecision decision;
+                    lastPlates = scheduler.process(image, ageMs, backlog, decision);
+                    decisions[(int)decision]++;
+                } else {
+                    lastPlates = detector.detectLicensePlates(image, maxPlates);
+                }
+                detector.clearRegionOfInterest();
+                if (writer) {
+                    std::string line = "{\"frame\":" + std::to_string(frame->frameId) + ",\"timestamp_ns\":" +
+                                       std::to_string(frame->timestampNs) + ",\"plates\":[";
+                    for (size_t p = 0; p < lastPlates.size(); p++) {
+                        const MyRect& r = lastPlates[p].rect;
+                        line += (p > 0 ? "," : "") + std::string("[") + std::to_string(r.x) + "," + std::to_string(r.y) +
+                                "," + std::to_string(r.width) + "," + std::to_string(r.height) + "," +
+                                std::to_string(lastPlates[p].score) + "]";
+                        Rect crop = Rect(r.x, r.y, r.width, r.height) & Rect(0, 0, image.cols, image.rows);
+                        if (!crop.empty()) {
+                            writer->submitCrop(frame->frameId, frame->timestampNs, r, image(crop));
+                        }
+                    }
+                    writer->submitLine(line + "]}");
+
+                    //timpii pe etape ai cadrului, comuni tuturor placutelor lui
+                    uint64_t stagesAfter[STAGE_COUNT];
+                    Metrics::stageTotals(stagesAfter);
+                    std::vector<DetectionRecord> detections(lastPlates.size());
+                    for (size_t p = 0; p < lastPlates.size(); p++) {
+                        DetectionRecord& record = detections[p];
+                        record.frameId = frame->frameId;
+                        record.timestampNs = frame->timestampNs;
+                        record.cameraId = cameraId;
+                        record.rect = lastPlates[p].rect;
+                        record.score = (float)lastPlates[p].score;
+                        for (int s = 0; s < STAGE_COUNT; s++) {
+                            record.stageMicros[s] = (uint32_t)((stagesAfter[s] - stagesBefore[s]) / 1000);
+                        }
+                    }
+                    if (!detections.empty()) {
+                        writer->submitDetections(std::move(detections));
+                    }
+                }
+            }
+            //placutele cadrului anterior nu apartin cadrului respins: nu se numara si nu ajung la
+            //tracker, care isi pastreaza pistele pana la urmatorul cadru bun
+            if (!rejected) {
+                plates += (long long)lastPlates.size();
+                if (runOcr) {
+                    report(tracker.update(image, lastPlates));
+                }
+            }
+        }
+        int64_t finished = monotonicNs();
+        double latencyMs = (finished - frame->captureNs) / 1e6;
+        latencyHistogram[(int)std::min<double>(LATENCY_HISTOGRAM_MS, std::max(0.0, latencyMs))]++;
+        ring.endRead();
+        frames++;
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (runOcr) {
+        report(tracker.flush());
+    }
+    if (!tracePath.empty()) {
+        Tracer::writeJson(tracePath);
+    }
+    std::cout << "Frames: " << frames << ", plates: " << plates << ", " << frames / seconds << " fps" << std::endl;
+    if (frames > 0) {
+        std::cout << "Average ring pickup latency: " << pickupMs / frames << " ms" << std::endl;
+        std::cout << "Capture-to-result latency: p50 " << latencyPercentile(latencyHistogram, frames / 2)
+                  << ", p99 " << latencyPercentile(latencyHistogram, std::min(frames - 1, frames * 99 / 100))
+                  << std::endl;
+    }
+    if (motionGate) {
+        std::cout << "Motion gate: " << idleFrames << " idle frames skipped detection" << std::endl;
+    }
+    if (writer) {
+        size_t maxDepth = writer->maxQueueDepth();
+        writer->stop();
+        std::cout << "Writer: " << writer->writtenItems() << " items in " << writer->batchCount() << " batches, "
+                  << writer->fsyncCount() << " fsyncs, max queue depth " << maxDepth << ", dropped "
+                  << writer->droppedItems() << std::endl;
+    }
+    if (useQualityGate) {
+        std::cout << "Quality gate: " << quality.evaluatedFrames() << " frames evaluated, " << quality.rejectedFrames()
+                  << " below thresholds (" << quality.rejectionRate() * 100 << "%), " << qualitySkipped
+                  << " skipped, " << quality.averageCostMs() << " ms per frame" << std::endl;
+    }
+    if (runOcr) {
+        std::cout << "OCR: " << tracker.ocrCalls() << " calls for " << vehicles << " vehicles";
+        if (vehicles > 0) {
+            std::cout << " (" << (double)tracker.ocrCalls() / vehicles << " per vehicle)";
+        }
+        std::cout << std::endl;
+    }
+    if (deadlineMs > 0) {
+        std::cout << "Scheduler decisions:";
+        for (int d = 0; d < 4; d++) {
+            std::cout << " " << decisionName((FrameDecision)d) << " " << decisions[d];
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
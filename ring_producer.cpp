@@ -0,0 +1,109 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "frame_ring.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+//producator de test: publica acelasi cadru de N ori in inel, cat de repede accepta consumatorul
+//(sau la --fps dat), si raporteaza debitul. Un cadru cu width = 0 marcheaza sfarsitul.
+int main(int argc, char** argv) {
+    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
+
+    std::string name = "/lpr_frames";
+    std::string imagePath;
+    std::string format = "nv12";
+    int frames = 1000;
+    int slots = 8;
+    double fps = 0; //0 = fara limita
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--name") name = value;
+        else if (key == "--image") imagePath = value;
+        else if (key == "--format") format = value;
+        else if (key == "--frames") frames = std::stoi(value);
+        else if (key == "--slots") slots = std::stoi(value);
+        else if (key == "--fps") fps = std::stod(value);
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+
+    //fara imagine: cadru 4K sintetic
+    Mat source = imagePath.empty() ? Mat(2160, 3840, CV_8UC3, Scalar(90, 120, 150)) : imread(imagePath, IMREAD_COLOR);
+    if (source.empty()) {
+        std::cout << "Could not open or find the image!" << std::endl;
+        return -1;
+    }
+
+    LicensePlateDetector detector;
+    Mat luma = detector.manualGrayscaleConversion(source);
+
+    //cadrul exact cum ar veni de la camera: BGR, doar Y, sau NV12 (Y + UV la 128)
+    FrameFormat frameFormat = FrameFormat::NV12;
+    std::vector<uchar> payload;
+    uint32_t stride = (uint32_t)source.cols;
+    if (format == "bgr") {
+        frameFormat = FrameFormat::BGR;
+        stride = (uint32_t)source.cols * 3;
+        for (int i = 0; i < source.rows; i++) {
+            payload.insert(payload.end(), source.ptr<uchar>(i), source.ptr<uchar>(i) + stride);
+        }
+    } else {
+        frameFormat = format == "gray" ? FrameFormat::GRAY : FrameFormat::NV12;
+        for (int i = 0; i < luma.rows; i++) {
+            payload.insert(payload.end(), luma.ptr<uchar>(i), luma.ptr<uchar>(i) + luma.cols);
+        }
+        if (frameFormat == FrameFormat::NV12) {
+            payload.resize(payload.size() + (size_t)luma.cols * ((luma.rows + 1) / 2), 128);
+        }
+    }
+
+    FrameRing ring;
+    if (!ring.create(name, (uint32_t)slots, (uint32_t)payload.size())) {
+        return -1;
+    }
+    std::cout << "Publishing " << frames << " frames of " << payload.size() << " bytes on " << name << std::endl;
+
+    Clock::time_point start = Clock::now();
+    auto period = std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0);
+    for (int i = 0; i <= frames; i++) {
+        FrameHeader* frame = nullptr;
+        uchar* data = nullptr;
+        while ((data = ring.beginWrite(frame)) == nullptr) {
+            std::this_thread::yield();
+        }
+
+        bool last = i == frames;
+        frame->frameId = (uint64_t)i;
+        frame->captureNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+        frame->timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        frame->width = last ? 0 : (uint32_t)source.cols;
+        frame->height = last ? 0 : (uint32_t)source.rows;
+        frame->stride = stride;
+        frame->format = (uint32_t)frameFormat;
+        frame->bytes = last ? 0 : (uint32_t)payload.size();
+        if (!last) {
+            std::memcpy(data, payload.data(), payload.size());
+        }
+        ring.commitWrite();
+
+        if (fps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(period * (i + 1)));
+        }
+    }
+
+    //asteptam consumatorul sa goleasca inelul inainte de shm_unlink
+    while (ring.pending() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Published " << frames << " frames in " << seconds << " s ("
+              << frames / seconds << " fps, " << frames * (double)payload.size() / seconds / 1e9 << " GB/s)" << std::endl;
+    return 0;
+}
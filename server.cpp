@@ -0,0 +1,299 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "server_protocol.h"
+#include "metrics.h"
+#include "tracer.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+struct ServerConfig {
+    std::string socketPath = "/tmp/lpr_detector.sock";
+    int workers = 4;
+    size_t queueCapacity = 64; //peste atat cererile sunt refuzate imediat
+    int maxConnections = 64; //fiecare conexiune are un thread de citire; peste atat sunt inchise imediat
+    int metricsPort = 0; //0 = fara endpoint /metrics
+    std::string metricsTextfile; //gol = fara fisier pentru node_exporter
+    std::string tracePath; //captura Chrome trace, gol = dezactivat
+    int traceSeconds = 10;
+};
+
+struct Connection {
+    int fd;
+    std::mutex writeMutex; //raspunsurile pot veni din mai multi workeri
+
+    explicit Connection(int _fd) : fd(_fd) {}
+    ~Connection() { ::close(fd); }
+
+    bool send(uint32_t requestId, uint32_t status, const std::string& body) {
+        ResponseHeader header = {RESPONSE_MAGIC, requestId, status, (uint32_t)body.size()};
+        std::lock_guard<std::mutex> lock(writeMutex);
+        return writeAll(fd, &header, sizeof(header)) && writeAll(fd, body.data(), body.size());
+    }
+};
+
+struct Request {
+    std::shared_ptr<Connection> connection;
+    uint32_t requestId;
+    uint32_t maxPlates;
+    std::vector<uchar> payload;
+    Clock::time_point admitted;
+};
+
+//coada de admitere marginita: cand e plina, cererea noua e refuzata (load shedding)
+class AdmissionQueue {
+public:
+    explicit AdmissionQueue(size_t _capacity) : capacity(_capacity) {}
+
+    bool tryPush(Request&& request) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.size() >= capacity) {
+                return false;
+            }
+            items.push_back(std::move(request));
+        }
+        notEmpty.notify_one();
+        return true;
+    }
+
+    //blocheaza pana la prima cerere
+    Request pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&] { return !items.empty(); });
+        Request request = std::move(items.front());
+        items.pop_front();
+        return request;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.size();
+    }
+
+private:
+    size_t capacity;
+    std::deque<Request> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+};
+
+struct ServerCounters {
+    std::atomic<long long> accepted{0};
+    std::atomic<long long> rejected{0};
+    std::atomic<long long> completed{0};
+    std::atomic<long long> closedConnections{0}; //inchise la accept, peste maxConnections
+    std::atomic<int> openConnections{0};
+};
+
+static std::string resultJson(const vector<PlateCandidate>& plates, double queueMs, double detectMs) {
+    json result;
+    result["plates"] = json::array();
+    for (const auto& plate : plates) {
+        result["plates"].push_back({
+            {"x", plate.rect.x}, {"y", plate.rect.y},
+            {"width", plate.rect.width}, {"height", plate.rect.height},
+            {"score", plate.score}
+        });
+    }
+    result["queue_ms"] = queueMs;
+    result["detect_ms"] = detectMs;
+    return result.dump();
+}
+
+//fiecare worker are propriul detector, creat o data la pornire (pool cald)
+static void workerLoop(int workerId, AdmissionQueue& queue, ServerCounters& counters) {
+    LicensePlateDetector detector;
+    detector.setDebugWindows(false);
+    Tracer::setThreadName("worker " + std::to_string(workerId));
+
+    while (true) {
+        Request request;
+        {
+            TraceSpan span("wait_request");
+            request = queue.pop();
+        }
+        Clock::time_point started = Clock::now();
+        uint64_t queueNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(started - request.admitted).count();
+        Tracer::complete("queue_wait", Tracer::nowNs() - queueNs, queueNs);
+
+        Mat image;
+        {
+            TraceSpan span("decode");
+            image = imdecode(request.payload, IMREAD_COLOR);
+        }
+        if (image.empty()) {
+            request.connection->send(request.requestId, STATUS_BAD_IMAGE, "{\"error\":\"bad image\"}");
+            continue;
+        }
+
+        vector<PlateCandidate> plates = detector.detectLicensePlates(image, (int)request.maxPlates);
+        Clock::time_point finished = Clock::now();
+
+        double queueMs = std::chrono::duration<double, std::milli>(started - request.admitted).count();
+        double detectMs = std::chrono::duration<double, std::milli>(finished - started).count();
+        {
+            TraceSpan span("respond");
+            request.connection->send(request.requestId, STATUS_OK, resultJson(plates, queueMs, detectMs));
+        }
+        counters.completed++;
+    }
+}
+
+static void connectionLoop(std::shared_ptr<Connection> connection, AdmissionQueue& queue, ServerCounters& counters) {
+    Tracer::setThreadName("connection " + std::to_string(connection->fd));
+    RequestHeader header;
+    while (readAll(connection->fd, &header, sizeof(header))) {
+        TraceSpan span("read_request");
+        if (header.magic != REQUEST_MAGIC || header.length > MAX_REQUEST_BYTES) {
+            break;
+        }
+
+        Request request;
+        request.connection = connection;
+        request.requestId = header.requestId;
+        request.maxPlates = header.maxPlates > 0 ? header.maxPlates : 1;
+        request.payload.resize(header.length);
+        if (!readAll(connection->fd, request.payload.data(), header.length)) {
+            break;
+        }
+        request.admitted = Clock::now();
+
+        if (queue.tryPush(std::move(request))) {
+            counters.accepted++;
+        } else {
+            counters.rejected++;
+            connection->send(header.requestId, STATUS_OVERLOADED, "{\"error\":\"overloaded\"}");
+        }
+    }
+}
+
+static ServerConfig parseArguments(int argc, char** argv) {
+    ServerConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--socket") config.socketPath = value;
+        else if (key == "--workers") config.workers = std::stoi(value);
+        else if (key == "--queue") config.queueCapacity = std::stoul(value);
+        else if (key == "--max-connections") config.maxConnections = std::stoi(value);
+        else if (key == "--metrics-port") config.metricsPort = std::stoi(value);
+        else if (key == "--metrics-textfile") config.metricsTextfile = value;
+        else if (key == "--trace") config.tracePath = value;
+        else if (key == "--trace-seconds") config.traceSeconds = std::stoi(value);
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+    return config;
+}
+
+int main(int argc, char** argv) {
+    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
+    std::signal(SIGPIPE, SIG_IGN); //clientii care inchid conexiunea nu opresc serverul
+
+    ServerConfig config = parseArguments(argc, argv);
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "Could not create socket" << std::endl;
+        return -1;
+    }
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (config.socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long" << std::endl;
+        return -1;
+    }
+    config.socketPath.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    ::unlink(config.socketPath.c_str());
+    if (::bind(listenFd, (sockaddr*)&address, sizeof(address)) < 0 || ::listen(listenFd, 128) < 0) {
+        std::cerr << "Could not listen on " << config.socketPath << std::endl;
+        return -1;
+    }
+
+    MetricsExporter exporter;
+    if (config.metricsPort > 0 && !exporter.startHttp(config.metricsPort)) {
+        std::cerr << "Could not serve metrics on port " << config.metricsPort << std::endl;
+    }
+    if (!config.metricsTextfile.empty()) {
+        exporter.startTextfile(config.metricsTextfile, 15);
+    }
+
+    AdmissionQueue queue(config.queueCapacity);
+    ServerCounters counters;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.workers; i++) {
+        workers.emplace_back(workerLoop, i, std::ref(queue), std::ref(counters));
+    }
+
+    //captura de trace pe o fereastra fixa, apoi scrisa o singura data
+    if (!config.tracePath.empty()) {
+        Tracer::setEnabled(true);
+        std::thread([&config] {
+            std::this_thread::sleep_for(std::chrono::seconds(config.traceSeconds));
+            Tracer::setEnabled(false);
+            if (Tracer::writeJson(config.tracePath)) {
+                std::cout << "Trace written to " << config.tracePath << " (dropped events: "
+                          << Tracer::droppedEvents() << ")" << std::endl;
+            }
+        }).detach();
+    }
+
+    std::thread reporter([&] {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(10));
+            std::cout << "accepted=" << counters.accepted << " rejected=" << counters.rejected
+                      << " completed=" << counters.completed << " connections=" << counters.openConnections
+                      << " closed=" << counters.closedConnections
+                      << " queued=" << queue.size() << std::endl;
+        }
+    });
+    reporter.detach();
+
+    std::cout << "Listening on " << config.socketPath << " with " << config.workers << " workers" << std::endl;
+    while (true) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            //EMFILE/ENFILE, ECONNABORTED si altele sunt trecatoare: serverul nu se opreste din cauza lor,
+            //iar pauza evita o bucla care ocupa un nucleu pana se elibereaza descriptori
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        //un thread detasat pe conexiune: numarul lor e marginit, altfel clientii care deschid conexiuni
+        //fara sa le inchida ar epuiza threadurile si memoria procesului
+        if (counters.openConnections.fetch_add(1) >= config.maxConnections) {
+            counters.openConnections--;
+            counters.closedConnections++;
+            ::close(fd);
+            continue;
+        }
+        std::thread([fd, &queue, &counters] {
+            connectionLoop(std::make_shared<Connection>(fd), queue, counters);
+            counters.openConnections--;
+        }).detach();
+    }
+
+    ::close(listenFd);
+    for (auto& worker : workers) {
+        worker.detach();
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <unistd.h>
+
+//protocol pe socket Unix, aceeasi conexiune poate trimite oricate cereri:
+//  cerere:  RequestHeader + length octeti de imagine codata (jpg/png)
+//  raspuns: ResponseHeader + length octeti de JSON
+const uint32_t REQUEST_MAGIC = 0x4C505244; // "LPRD"
+const uint32_t RESPONSE_MAGIC = 0x4C505253; // "LPRS"
+const uint32_t MAX_REQUEST_BYTES = 64u << 20;
+
+struct RequestHeader {
+    uint32_t magic;
+    uint32_t requestId;
+    uint32_t maxPlates;
+    uint32_t length;
+};
+
+struct ResponseHeader {
+    uint32_t magic;
+    uint32_t requestId;
+    uint32_t status; //0 ok, 1 coada plina, 2 imagine invalida
+    uint32_t length;
+};
+
+enum ResponseStatus : uint32_t {
+    STATUS_OK = 0,
+    STATUS_OVERLOADED = 1,
+    STATUS_BAD_IMAGE = 2
+};
+
+inline bool readAll(int fd, void* buffer, size_t size) {
+    char* p = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+inline bool writeAll(int fd, const void* buffer, size_t size) {
+    const char* p = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+//SSE2 pe x86-64 (mereu disponibil), NEON pe ARM; fara niciunul raman buclele scalare
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LPR_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LPR_NEON 1
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+#include "stage_cache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//antetul fisierelor de pe disc; imediat dupa el vin randurile compacte ale matricei
+struct SpillHeader {
+    uint32_t magic;
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+};
+static const uint32_t SPILL_MAGIC = 0x4C505343; // "LPSC"
+
+StageCache::StageCache(size_t _maxBytes, const string& _spillDirectory)
+    : maxBytes(_maxBytes), usedBytes(0), spillDirectory(_spillDirectory) {
+}
+
+//hash pe cuvinte de 8 octeti (multiply-rotate), mult mai rapid decat un hash pe octet;
+//dimensiunea si tipul intra si ele in hash
+uint64_t StageCache::hashImage(const Mat& image) {
+    const uint64_t k1 = 0x9E3779B97F4A7C15ull;
+    const uint64_t k2 = 0xC2B2AE3D27D4EB4Full;
+    uint64_t h = combine(combine((uint64_t)image.rows, (uint64_t)image.cols), (uint64_t)image.type());
+    size_t rowBytes = (size_t)image.cols * image.elemSize();
+
+    for (int i = 0; i < image.rows; i++) {
+        const uchar* row = image.ptr<uchar>(i);
+        size_t j = 0;
+        for (; j + 8 <= rowBytes; j += 8) {
+            uint64_t word;
+            memcpy(&word, row + j, 8);
+            h ^= word * k1;
+            h = ((h << 31) | (h >> 33)) * k2;
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, row + j, rowBytes - j);
+        h ^= tail * k1;
+        h = ((h << 31) | (h >> 33)) * k2;
+    }
+    return h ^ (h >> 29);
+}
+
+uint64_t StageCache::combine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+uint64_t StageCache::entryKey(PipelineStage stage, uint64_t key) {
+    return combine(key, (uint64_t)stage + 1);
+}
+
+bool StageCache::lookup(PipelineStage stage, uint64_t key, Mat& value) {
+    uint64_t id = entryKey(stage, key);
+    lock_guard<mutex> lock(cacheMutex);
+
+    auto it = entries.find(id);
+    if (it != entries.end()) {
+        lru.splice(lru.begin(), lru, it->second.lruPosition);
+        value = it->second.value;
+        memoryHits[stage]++;
+        return true;
+    }
+    if (!spillDirectory.empty() && loadSpilled(id, value)) {
+        insert(id, value);
+        diskHits[stage]++;
+        return true;
+    }
+    misses[stage]++;
+    return false;
+}
+
+void StageCache::store(PipelineStage stage, uint64_t key, const Mat& value) {
+    uint64_t id = entryKey(stage, key);
+    lock_guard<mutex> lock(cacheMutex);
+    if (entries.count(id) > 0) {
+        return;
+    }
+    //write-through: o rulare ulterioara a evaluarii gaseste etapele deja pe disc
+    if (!spillDirectory.empty()) {
+        spill(id, value);
+    }
+    insert(id, value);
+}
+
+void StageCache::insert(uint64_t id, const Mat& value) {
+    size_t bytes = value.total() * value.elemSize();
+    while (!lru.empty() && usedBytes + bytes > maxBytes) {
+        auto victim = entries.find(lru.back());
+        usedBytes -= victim->second.bytes;
+        entries.erase(victim);
+        lru.pop_back();
+    }
+    if (bytes > maxBytes) {
+        return;
+    }
+    lru.push_front(id);
+    entries[id] = {value, bytes, lru.begin()};
+    usedBytes += bytes;
+}
+
+void StageCache::clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    entries.clear();
+    lru.clear();
+    usedBytes = 0;
+}
+
+string StageCache::spillPath(uint64_t id) const {
+    ostringstream path;
+    path << spillDirectory << "/" << hex << setw(16) << setfill('0') << id << ".stage";
+    return path.str();
+}
+
+void StageCache::spill(uint64_t id, const Mat& value) const {
+    string path = spillPath(id);
+    string temporary = path + ".tmp";
+    ofstream out(temporary, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        return;
+    }
+    SpillHeader header = {SPILL_MAGIC, value.rows, value.cols, value.type()};
+    out.write((const char*)&header, sizeof(header));
+    size_t rowBytes = (size_t)value.cols * value.elemSize();
+    for (int i = 0; i < value.rows; i++) {
+        out.write((const char*)value.ptr<uchar>(i), (streamsize)rowBytes);
+    }
+    out.close();
+    if (out.good()) {
+        std::rename(temporary.c_str(), path.c_str());
+    } else {
+        std::remove(temporary.c_str());
+    }
+}
+
+#ifndef _WIN32
+bool StageCache::loadSpilled(uint64_t id, Mat& value) const {
+    int fd = ::open(spillPath(id).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SpillHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const SpillHeader* header = (const SpillHeader*)mapped;
+    bool valid = header->magic == SPILL_MAGIC;
+    if (valid) {
+        Mat view(header->rows, header->cols, header->type, (uchar*)mapped + sizeof(SpillHeader));
+        valid = sizeof(SpillHeader) + view.total() * view.elemSize() <= (size_t)info.st_size;
+        if (valid) {
+            value = view.clone(); //copia ramane in memorie dupa munmap
+        }
+    }
+    ::munmap(mapped, (size_t)info.st_size);
+    return valid;
+}
+#else
+bool StageCache::loadSpilled(uint64_t id, Mat& value) const {
+    ifstream in(spillPath(id), ios::binary);
+    SpillHeader header;
+    if (!in.read((char*)&header, sizeof(header)) || header.magic != SPILL_MAGIC) {
+        return false;
+    }
+    Mat loaded(header.rows, header.cols, header.type);
+    if (!in.read((char*)loaded.data, (streamsize)(loaded.total() * loaded.elemSize()))) {
+        return false;
+    }
+    value = loaded;
+    return true;
+}
+#endif
+
+double StageCache::hitRate(PipelineStage stage) const {
+    lock_guard<mutex> lock(cacheMutex);
+    long long hits = memoryHits[stage] + diskHits[stage];
+    long long total = hits + misses[stage];
+    return total > 0 ? (double)hits / total : 0.0;
+}
+
+void StageCache::printStats(ostream& out) const {
+    lock_guard<mutex> lock(cacheMutex);
+    out << "Stage cache (" << usedBytes / (1 << 20) << " MB in memory, " << entries.size() << " entries):" << endl;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        long long total = memoryHits[s] + diskHits[s] + misses[s];
+        if (total == 0) {
+            continue;
+        }
+        out << "  " << stageName((PipelineStage)s) << ": " << memoryHits[s] << " memory hits, " << diskHits[s]
+            << " disk hits, " << misses[s] << " misses (" << 100.0 * (memoryHits[s] + diskHits[s]) / total
+            << "% hit rate)" << endl;
+    }
+}
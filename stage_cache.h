@@ -0,0 +1,56 @@
+#ifndef STAGE_CACHE_H
+#define STAGE_CACHE_H
+#include <opencv2/opencv.hpp>
+#include "metrics.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+using namespace std;
+using namespace cv;
+
+//cache pentru rezultatele etapelor timpurii (gri, blur, Sobel, prag), cheiat dupa
+//(hash-ul continutului imaginii, hash-ul parametrilor din amonte). La o baleiere a
+//parametrilor tarzii (arie, aspect, selectie) etapele timpurii se calculeaza o singura data.
+//In memorie cu LRU pe octeti; optional si pe disc, intr-un format brut care se poate mmap-a.
+class StageCache {
+public:
+    explicit StageCache(size_t maxBytes = (size_t)512 << 20, const string& spillDirectory = "");
+
+    bool lookup(PipelineStage stage, uint64_t key, Mat& value);
+    void store(PipelineStage stage, uint64_t key, const Mat& value);
+    void clear();
+
+    static uint64_t hashImage(const Mat& image);
+    static uint64_t combine(uint64_t seed, uint64_t value);
+
+    double hitRate(PipelineStage stage) const;
+    void printStats(ostream& out) const;
+
+private:
+    struct Entry {
+        Mat value;
+        size_t bytes;
+        list<uint64_t>::iterator lruPosition;
+    };
+
+    static uint64_t entryKey(PipelineStage stage, uint64_t key);
+    string spillPath(uint64_t entryKey) const;
+    bool loadSpilled(uint64_t entryKey, Mat& value) const;
+    void spill(uint64_t entryKey, const Mat& value) const;
+    void insert(uint64_t entryKey, const Mat& value);
+
+    size_t maxBytes;
+    size_t usedBytes;
+    string spillDirectory;
+    unordered_map<uint64_t, Entry> entries;
+    list<uint64_t> lru; //fata = cel mai recent folosit
+    mutable mutex cacheMutex;
+
+    long long memoryHits[STAGE_COUNT] = {};
+    long long diskHits[STAGE_COUNT] = {};
+    long long misses[STAGE_COUNT] = {};
+};
+
+#endif
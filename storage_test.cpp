@@ -0,0 +1,280 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "crop_archive.h"
+#include "detection_log.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+//teste de format pentru stocare (arhiva de decupaje, jurnalul de detectii): scriere, recitire
+//prin mmap si recuperare dupa o coada taiata (scriere intrerupta). Ruleaza intr-un director temporar si intoarce 0 daca totul se potriveste
+
+//decupajul de test i: dimensiuni si canale variabile, pixeli determinati de pozitie
+static cv::Mat verifyCrop(int i) {
+    int channels = i % 2 == 0 ? 1 : 3;
+    cv::Mat crop(8 + i % 17, 20 + i % 31, CV_8UC(channels));
+    for (int r = 0; r < crop.rows; r++) {
+        uchar* row = crop.ptr<uchar>(r);
+        for (int c = 0; c < crop.cols * channels; c++) {
+            row[c] = (uchar)(i * 31 + r * 7 + c * 3);
+        }
+    }
+    return crop;
+}
+
+//compara arhiva cu primele expected decupaje de test: campurile intrarilor, pixelii si
+//offset-urile (contigue in fiecare segment, de la headerul fisierului)
+static int checkArchive(const std::string& directory, int expected) {
+    CropArchiveReader reader;
+    if (!reader.open(directory)) {
+        std::cerr << "crop archive: could not reopen " << directory << std::endl;
+        return 1;
+    }
+    if ((int)reader.size() != expected) {
+        std::cerr << "crop archive: expected " << expected << " crops, reader has " << reader.size() << std::endl;
+        return 1;
+    }
+    int bad = 0;
+    std::vector<uint64_t> nextOffset;
+    const auto& all = reader.all();
+    for (int i = 0; i < expected; i++) {
+        const CropArchiveReader::Location& location = all[i];
+        const CropIndexEntry& entry = *location.entry;
+        cv::Mat crop = verifyCrop(i);
+        if ((int)nextOffset.size() <= location.segment) {
+            nextOffset.resize(location.segment + 1, CROP_FILE_HEADER_BYTES);
+        }
+        bool fields = entry.frameId == (uint64_t)(i / 2) && entry.timestampNs == 1000 + i && entry.x == i % 100 &&
+                      entry.y == i % 50 && entry.width == 2 * crop.cols && entry.height == 2 * crop.rows &&
+                      entry.cropWidth == crop.cols && entry.cropHeight == crop.rows &&
+                      entry.channels == crop.channels() && entry.offset == nextOffset[location.segment];
+        nextOffset[location.segment] = entry.offset + entry.length;
+
+        cv::Mat stored = reader.crop(location);
+        bool pixels = stored.rows == crop.rows && stored.cols == crop.cols && stored.channels() == crop.channels();
+        for (int r = 0; pixels && r < crop.rows; r++) {
+            pixels = std::memcmp(stored.ptr<uchar>(r), crop.ptr<uchar>(r), (size_t)crop.cols * crop.channels()) == 0;
+        }
+        if (!fields || !pixels) {
+            if (bad++ < 10) {
+                std::cerr << "crop archive: crop " << i << (fields ? "" : " index entry") << (pixels ? "" : " pixels")
+                          << " differ" << std::endl;
+            }
+        }
+    }
+    if (expected > 0 && reader.find((uint64_t)((expected - 1) / 2)).size() != (size_t)(expected % 2 == 0 ? 2 : 1)) {
+        std::cerr << "crop archive: find() missed crops of the last frame" << std::endl;
+        bad++;
+    }
+    return bad > 0 ? 1 : 0;
+}
+
+//scrie count decupaje RAW intr-un director nou (segmente mici, ca sa se si roteasca), le reciteste
+//prin mmap, apoi taie coada ultimului segment (date partiale + intrare de index partiala) si
+//verifica faptul ca ramane exact ultimul decupaj pierdut
+static int verifyArchive(const std::string& directory, int count, uint64_t segmentBytes) {
+    std::error_code error;
+    fs::remove_all(directory, error);
+    ArchiveConfig config;
+    config.directory = directory;
+    config.segmentBytes = segmentBytes;
+    config.encoding = CropEncoding::RAW;
+    {
+        CropArchiveWriter writer;
+        if (!writer.open(config)) {
+            return -1;
+        }
+        for (int i = 0; i < count; i++) {
+            cv::Mat crop = verifyCrop(i);
+            if (!writer.append((uint64_t)(i / 2), 1000 + i, MyRect(i % 100, i % 50, 2 * crop.cols, 2 * crop.rows), crop)) {
+                std::cerr << "crop archive: append " << i << " failed" << std::endl;
+                return 1;
+            }
+        }
+        writer.close();
+    }
+    if (checkArchive(directory, count) != 0) {
+        return 1;
+    }
+    std::cout << "crop archive: " << count << " crops round-tripped" << std::endl;
+    if (count == 0) {
+        return 0;
+    }
+
+    //ultimul segment: jumatate din ultimul payload taiata, plus o intrare de index scrisa pe jumatate
+    fs::path lastData, lastIndex;
+    for (const auto& file : fs::directory_iterator(directory)) {
+        if (file.path().extension() == ".dat" && (lastData.empty() || file.path() > lastData)) {
+            lastData = file.path();
+        }
+    }
+    lastIndex = lastData;
+    lastIndex.replace_extension(".idx");
+    uint64_t lastLength = verifyCrop(count - 1).total() * verifyCrop(count - 1).channels();
+    fs::resize_file(lastData, fs::file_size(lastData) - (lastLength + 1) / 2);
+    if (FILE* index = fopen(lastIndex.string().c_str(), "ab")) {
+        char partial[sizeof(CropIndexEntry) / 2] = {};
+        fwrite(partial, 1, sizeof(partial), index);
+        fclose(index);
+    }
+    if (checkArchive(directory, count - 1) != 0) {
+        std::cerr << "crop archive: truncated tail was not handled" << std::endl;
+        return 1;
+    }
+    std::cout << "crop archive: truncated tail drops only the torn crop" << std::endl;
+    return 0;
+}
+
+//randul de test i: patru camere, timestamp-uri Unix crescatoare
+static DetectionRecord verifyRecord(uint64_t i) {
+    DetectionRecord record;
+    record.frameId = i;
+    record.timestampNs = 1700000000000000000ll + (int64_t)i * 1000;
+    record.cameraId = (uint32_t)(i % 4);
+    record.rect = MyRect((int)(i % 640), (int)(i % 480), 100 + (int)(i % 50), 30 + (int)(i % 20));
+    record.score = (float)(i % 1000) / 8.0f;
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        record.stageMicros[s] = (uint32_t)(i * 7 + s);
+    }
+    return record;
+}
+
+//compara jurnalul cu primele expected randuri de test: fiecare coloana, indexul blocurilor
+//(offset-uri aliniate si crescatoare, intervale corecte) si o interogare fata de numararea directa
+static int checkLog(const std::string& path, uint64_t expected, bool closed) {
+    DetectionLogReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "detection log: could not reopen " << path << std::endl;
+        return 1;
+    }
+    if (reader.rowCount() != expected || reader.wasClosed() != closed || reader.stageCount() != STAGE_COUNT) {
+        std::cerr << "detection log: expected " << expected << " rows (" << (closed ? "closed" : "unclosed") << "), reader has "
+                  << reader.rowCount() << " (" << (reader.wasClosed() ? "closed" : "unclosed") << ")" << std::endl;
+        return 1;
+    }
+    uint64_t bad = 0, row = 0, previousOffset = 0;
+    for (size_t b = 0; b < reader.blockCount(); b++) {
+        DetectionLogReader::Block block = reader.block(b);
+        const DetectionBlockInfo& info = *block.info;
+        if (info.offset % 64 != 0 || info.offset <= previousOffset) {
+            std::cerr << "detection log: block " << b << " has offset " << info.offset << std::endl;
+            bad++;
+        }
+        previousOffset = info.offset;
+        if (block.rows > 0 && (info.minTimestampNs != verifyRecord(row).timestampNs ||
+                               info.maxTimestampNs != verifyRecord(row + block.rows - 1).timestampNs)) {
+            std::cerr << "detection log: block " << b << " has a wrong timestamp range" << std::endl;
+            bad++;
+        }
+        for (uint32_t r = 0; r < block.rows; r++, row++) {
+            DetectionRecord record = verifyRecord(row);
+            bool same = block.frameId[r] == record.frameId && block.timestampNs[r] == record.timestampNs &&
+                        block.cameraId[r] == record.cameraId && block.x[r] == record.rect.x &&
+                        block.y[r] == record.rect.y && block.width[r] == record.rect.width &&
+                        block.height[r] == record.rect.height && block.score[r] == record.score;
+            for (int s = 0; same && s < STAGE_COUNT; s++) {
+                same = block.stage(s)[r] == record.stageMicros[s];
+            }
+            if (!same && bad++ < 10) {
+                std::cerr << "detection log: row " << row << " differs" << std::endl;
+            }
+        }
+    }
+
+    DetectionQuery query;
+    query.camera = 1;
+    query.fromNs = verifyRecord(expected / 3).timestampNs;
+    query.toNs = verifyRecord(2 * expected / 3).timestampNs;
+    uint64_t direct = 0;
+    for (uint64_t i = expected / 3; i < 2 * expected / 3; i++) {
+        direct += i % 4 == 1;
+    }
+    if (reader.count(query) != direct || reader.filter(query).size() != direct) {
+        std::cerr << "detection log: query matched " << reader.count(query) << " rows, expected " << direct << std::endl;
+        bad++;
+    }
+    return bad > 0 ? 1 : 0;
+}
+
+//scrie count randuri intr-un fisier nou (blocuri de blockRows, ultimul partial), le reciteste prin
+//mmap, apoi taie footer-ul si o parte din ultimul bloc (ca dupa un crash): cititorul trebuie sa
+//recupereze blocurile complete, iar scriitorul sa continue dupa ele
+static int verifyLog(const std::string& path, uint64_t count, uint32_t blockRows) {
+    std::error_code error;
+    fs::remove(path, error);
+    {
+        DetectionLogWriter writer;
+        if (!writer.open(path, blockRows)) {
+            return -1;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            writer.append(verifyRecord(i));
+        }
+        if (!writer.close()) {
+            return 1;
+        }
+    }
+    if (checkLog(path, count, true) != 0) {
+        return 1;
+    }
+    std::cout << "detection log: " << count << " detections round-tripped" << std::endl;
+
+    uint64_t lastRows = 0, blocks = 0;
+    {
+        DetectionLogReader reader;
+        reader.open(path);
+        blocks = reader.blockCount();
+        lastRows = blocks > 0 ? reader.block(blocks - 1).rows : 0;
+    }
+    if (blocks == 0) {
+        return 0;
+    }
+    //sfarsitul ultimului bloc = inaintea footer-ului si a trailer-ului; un octet mai putin il rupe
+    uint64_t dataEnd = fs::file_size(path) - blocks * sizeof(DetectionBlockInfo) - sizeof(DetectionLogTrailer);
+    fs::resize_file(path, dataEnd - 1);
+    if (checkLog(path, count - lastRows, false) != 0) {
+        std::cerr << "detection log: unclosed log was not recovered" << std::endl;
+        return 1;
+    }
+    std::cout << "detection log: unclosed log recovers " << count - lastRows << " detections" << std::endl;
+
+    {
+        DetectionLogWriter writer;
+        if (!writer.open(path, blockRows)) {
+            return 1;
+        }
+        for (uint64_t i = count - lastRows; i < count; i++) {
+            writer.append(verifyRecord(i));
+        }
+        writer.close();
+    }
+    if (checkLog(path, count, true) != 0) {
+        std::cerr << "detection log: appending after recovery lost rows" << std::endl;
+        return 1;
+    }
+    std::cout << "detection log: reopened log appends after the last complete block" << std::endl;
+    return 0;
+}
+
+int main() {
+    fs::path root = fs::temp_directory_path() / "lpr_storage_test";
+    int failures = 0;
+
+    //un singur decupaj, apoi destule ca segmentele de 64 KiB sa se roteasca de mai multe ori
+    for (int count : {1, 500}) {
+        failures += verifyArchive((root / ("crops_" + std::to_string(count))).string(), count, 64 << 10) != 0;
+    }
+    //blocuri de 4096 randuri: ultimul bloc partial, un numar exact de blocuri, multe blocuri
+    fs::create_directories(root);
+    for (uint64_t count : {100ull, 8192ull, 100000ull}) {
+        failures += verifyLog((root / ("detections_" + std::to_string(count) + ".lprlog")).string(), count, 4096) != 0;
+    }
+
+    std::error_code error;
+    fs::remove_all(root, error);
+    std::cout << (failures == 0 ? "All storage tests passed" : "Storage tests FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
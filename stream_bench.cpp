@@ -0,0 +1,124 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "stream_executor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+//benchmark pentru StreamExecutor: de la 1 la N fluxuri, fiecare cu cel mult `inflight`
+//cadre in lucru, si raporteaza FPS total si FPS pe nucleu; verifica si ordinea livrarii
+
+struct StreamState {
+    std::atomic<int> inFlight{0};
+    std::atomic<long long> delivered{0};
+    std::atomic<long long> outOfOrder{0};
+    uint64_t expected = 0; //scris doar din callback, care e serializat pe flux
+};
+
+int main(int argc, char** argv) {
+    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
+
+    fs::path imageDir = fs::current_path().parent_path() / "Tests";
+    int maxStreams = 48;
+    int workers = 0;
+    int inflight = 2;
+    double seconds = 5.0;
+    bool pin = false;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--images") imageDir = value;
+        else if (key == "--max-streams") maxStreams = std::stoi(value);
+        else if (key == "--workers") workers = std::stoi(value);
+        else if (key == "--inflight") inflight = std::max(1, std::stoi(value));
+        else if (key == "--seconds") seconds = std::stod(value);
+        else if (key == "--pin") pin = value != "0";
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+
+    std::vector<cv::Mat> images;
+    if (fs::is_directory(imageDir)) {
+        for (const auto& entry : fs::directory_iterator(imageDir)) {
+            cv::Mat image = cv::imread(entry.path().string());
+            if (!image.empty()) {
+                images.push_back(image);
+            }
+        }
+    }
+    if (images.empty()) {
+        std::cerr << "No images found in " << imageDir << std::endl;
+        return -1;
+    }
+
+    std::vector<int> streamCounts;
+    for (int n = 1; n < maxStreams; n *= 2) {
+        streamCounts.push_back(n);
+    }
+    streamCounts.push_back(maxStreams);
+
+    std::cout << "streams  fps      fps/core  striped  stolen  out-of-order" << std::endl;
+    for (int streamCount : streamCounts) {
+        ExecutorConfig config;
+        config.workers = workers;
+        config.pinWorkers = pin;
+        StreamExecutor executor(config);
+
+        std::vector<std::unique_ptr<StreamState>> states;
+        for (int s = 0; s < streamCount; s++) {
+            states.push_back(std::make_unique<StreamState>());
+            StreamState* state = states.back().get();
+            executor.addStream([state](uint64_t frameIndex, const vector<PlateCandidate>&) {
+                if (frameIndex != state->expected) {
+                    state->outOfOrder++;
+                }
+                state->expected = frameIndex + 1;
+                state->delivered++;
+                state->inFlight--;
+            });
+        }
+
+        //un singur thread care tine fiecare flux la `inflight` cadre in lucru
+        Clock::time_point start = Clock::now();
+        Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        std::vector<size_t> nextImage(streamCount);
+        for (int s = 0; s < streamCount; s++) {
+            nextImage[s] = s % images.size();
+        }
+        while (Clock::now() < end) {
+            bool submitted = false;
+            for (int s = 0; s < streamCount; s++) {
+                if (states[s]->inFlight < inflight) {
+                    states[s]->inFlight++;
+                    executor.submit(s, images[nextImage[s]]);
+                    nextImage[s] = (nextImage[s] + 1) % images.size();
+                    submitted = true;
+                }
+            }
+            if (!submitted) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        executor.shutdown();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        long long delivered = 0;
+        long long outOfOrder = 0;
+        for (const auto& state : states) {
+            delivered += state->delivered;
+            outOfOrder += state->outOfOrder;
+        }
+        double fps = delivered / elapsed;
+        printf("%-8d %-8.1f %-9.2f %-8lld %-7lld %lld\n", streamCount, fps, fps / executor.workerCount(),
+               executor.stripedFrames(), executor.stolenTasks(), outOfOrder);
+    }
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "stream_executor.h"
+#include "tracer.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+StreamExecutor::StreamExecutor(const ExecutorConfig& _config) : config(_config) {
+    int count = config.workers > 0 ? config.workers : (int)max(1u, thread::hardware_concurrency());
+    for (int i = 0; i < count; i++) {
+        queues.push_back(make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < count; i++) {
+        workers.emplace_back(&StreamExecutor::workerLoop, this, i);
+#ifdef __linux__
+        if (config.pinWorkers) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % (int)max(1u, thread::hardware_concurrency()), &cpus);
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpus), &cpus);
+        }
+#endif
+    }
+}
+
+StreamExecutor::~StreamExecutor() {
+    shutdown();
+}
+
+int StreamExecutor::addStream(ResultCallback callback) {
+    lock_guard<mutex> lock(streamsMutex);
+    streams.push_back(make_unique<Stream>());
+    streams.back()->callback = move(callback);
+    streams.back()->homeWorker = (int)(streams.size() - 1) % (int)queues.size();
+    return (int)streams.size() - 1;
+}
+
+//cat trebuie extinsa o banda ca o placuta cu centrul in ea sa fie vazuta intreaga: jumatate din
+//inaltimea maxima a unei placute (aria maxima la raportul minim) plus marginile blur/Sobel/morfologie
+static int stripeOverlap(const DetectorParams& params, int frameWidth) {
+    int plateHeight = (int)ceil(sqrt(params.maxPlateArea / params.aspectRatioMin));
+    int margin = params.blurKernelSize / 2 + 1 + params.morphHeight / 2;
+    return (plateHeight / 2 + margin + 1) * LicensePlateDetector::normalizationFactor(frameWidth, params.canonicalWidth);
+}
+
+//benzi orizontale doar cand sunt mai putine fluxuri active decat workeri, si doar atatea cate
+//nu repeta prea mult din cadru: suprapunerile se proceseaza de doua ori
+vector<Rect> StreamExecutor::stripesFor(const Mat& frame, int overlap) {
+    int active = max(1, activeStreams.load());
+    for (int count = min(config.maxStripes, (int)queues.size() / active); count >= 2; count--) {
+        vector<Rect> stripes;
+        long long processed = 0;
+        for (int s = 0; s < count; s++) {
+            int y1 = frame.rows * s / count;
+            int y2 = frame.rows * (s + 1) / count;
+            stripes.push_back(Rect(0, y1, frame.cols, y2 - y1));
+            processed += min(frame.rows, y2 + overlap) - max(0, y1 - overlap);
+        }
+        if (processed <= config.maxStripeOverhead * frame.rows) {
+            return stripes;
+        }
+    }
+    return {};
+}
+
+uint64_t StreamExecutor::submit(int streamId, const Mat& frame) {
+    Stream* stream;
+    {
+        lock_guard<mutex> lock(streamsMutex);
+        stream = streams[streamId].get();
+    }
+
+    auto job = make_shared<FrameJob>();
+    job->stream = streamId;
+    job->frame = frame;
+    {
+        lock_guard<mutex> lock(stream->deliverMutex);
+        job->index = stream->nextSubmit++;
+    }
+    if (stream->inFlight++ == 0) {
+        activeStreams++;
+    }
+    pendingFrames++;
+
+    job->overlap = stripeOverlap(config.params, frame.cols);
+    job->stripes = stripesFor(frame, job->overlap);
+    int tasks = max(1, (int)job->stripes.size());
+    job->parts.resize(tasks);
+    job->remaining = tasks;
+    if (tasks > 1) {
+        striped++;
+    }
+    //toate benzile in coada worker-ului de acasa; ceilalti le fura
+    for (int t = 0; t < tasks; t++) {
+        push(stream->homeWorker, Task{job, job->stripes.empty() ? -1 : t});
+    }
+    return job->index;
+}
+
+void StreamExecutor::push(int workerId, Task&& task) {
+    {
+        lock_guard<mutex> lock(queues[workerId]->queueMutex);
+        queues[workerId]->tasks.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> lock(idleMutex);
+        queuedTasks++;
+    }
+    idleCondition.notify_all();
+}
+
+//coada proprie din fata (ordinea cadrelor), apoi furt din spatele celorlalte cozi
+bool StreamExecutor::popTask(int workerId, Task& task) {
+    int count = (int)queues.size();
+    for (int k = 0; k < count; k++) {
+        WorkerQueue& queue = *queues[(workerId + k) % count];
+        lock_guard<mutex> lock(queue.queueMutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (k == 0) {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+            stolen++;
+        }
+        queuedTasks--;
+        return true;
+    }
+    return false;
+}
+
+void StreamExecutor::workerLoop(int workerId) {
+    Tracer::setThreadName("executor " + to_string(workerId));
+    LicensePlateDetector detector(config.params);
+    detector.setDebugWindows(false);
+
+    while (true) {
+        Task task;
+        if (popTask(workerId, task)) {
+            runTask(detector, task);
+            continue;
+        }
+        unique_lock<mutex> lock(idleMutex);
+        idleCondition.wait(lock, [&] { return queuedTasks > 0 || !running; });
+        if (!running && queuedTasks == 0) {
+            return;
+        }
+    }
+}
+
+//o banda e procesata ca ROI extins cu job.overlap, ca placutele de pe granita sa fie vazute
+//intregi; o placuta apartine benzii in care ii cade centrul, deci nu apare de doua ori.
+//Fiecare banda are propriul prag Otsu.
+void StreamExecutor::runTask(LicensePlateDetector& detector, const Task& task) {
+    FrameJob& job = *task.job;
+    TraceSpan span(task.stripe < 0 ? "frame" : "stripe");
+    vector<PlateCandidate> plates;
+    if (task.stripe < 0) {
+        plates = detector.detectLicensePlates(job.frame, config.maxPlates);
+    } else {
+        const Rect& own = job.stripes[task.stripe];
+        Rect extended(own.x, own.y - job.overlap, own.width, own.height + 2 * job.overlap);
+        extended &= Rect(0, 0, job.frame.cols, job.frame.rows);
+
+        detector.setRegionOfInterest(vector<Rect>{extended});
+        for (const auto& plate : detector.detectLicensePlates(job.frame, config.maxPlates)) {
+            int cy = plate.rect.y + plate.rect.height / 2;
+            if (cy >= own.y && cy < own.y + own.height) {
+                plates.push_back(plate);
+            }
+        }
+        detector.clearRegionOfInterest();
+    }
+    job.parts[max(0, task.stripe)] = move(plates);
+
+    if (--job.remaining == 0) {
+        complete(job);
+    }
+}
+
+void StreamExecutor::complete(FrameJob& job) {
+    vector<PlateCandidate> merged;
+    for (auto& part : job.parts) {
+        merged.insert(merged.end(), part.begin(), part.end());
+    }
+    stable_sort(merged.begin(), merged.end(), [](const PlateCandidate& a, const PlateCandidate& b) {
+        return a.score > b.score;
+    });
+    if ((int)merged.size() > config.maxPlates) {
+        merged.resize(config.maxPlates);
+    }
+    job.frame.release();
+
+    Stream* stream;
+    {
+        lock_guard<mutex> lock(streamsMutex);
+        stream = streams[job.stream].get();
+    }
+    int delivered = 0;
+    {
+        //callback-urile unui flux ruleaza sub mutexul lui, deci niciodata in paralel sau in alta ordine
+        lock_guard<mutex> lock(stream->deliverMutex);
+        stream->ready[job.index] = move(merged);
+        auto it = stream->ready.find(stream->nextDeliver);
+        while (it != stream->ready.end()) {
+            if (stream->callback) {
+                stream->callback(it->first, it->second);
+            }
+            stream->ready.erase(it);
+            stream->nextDeliver++;
+            delivered++;
+            it = stream->ready.find(stream->nextDeliver);
+        }
+    }
+    if (delivered > 0) {
+        if ((stream->inFlight -= delivered) == 0) {
+            activeStreams--;
+        }
+        lock_guard<mutex> lock(idleMutex);
+        pendingFrames -= delivered;
+        drainedCondition.notify_all();
+    }
+}
+
+void StreamExecutor::shutdown() {
+    {
+        unique_lock<mutex> lock(idleMutex);
+        drainedCondition.wait(lock, [&] { return pendingFrames == 0; });
+        running = false;
+    }
+    idleCondition.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef STREAM_EXECUTOR_H
+#define STREAM_EXECUTOR_H
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace cv;
+
+struct ExecutorConfig {
+    int workers = 0; //0 = cate nuclee are masina
+    bool pinWorkers = false; //worker i fixat pe nucleul i (doar Linux)
+    int maxPlates = 3;
+    int maxStripes = 4; //un cadru se imparte in cel mult atatea benzi orizontale
+    double maxStripeOverhead = 1.5; //randurile procesate de toate benzile / randurile cadrului, cel mult
+    DetectorParams params;
+};
+
+//rezultatele unui flux sosesc in ordinea in care au fost trimise cadrele
+using ResultCallback = function<void(uint64_t frameIndex, const vector<PlateCandidate>& plates)>;
+
+//executor cu work stealing pentru multe camere: fiecare worker are coada lui si propriul
+//detector; cadrele unui flux merg mereu in coada aceluiasi worker (localitate), iar un worker
+//fara treaba fura de la coada celorlalti. Cand sunt mai putine fluxuri active decat workeri,
+//un cadru e impartit in benzi procesate in paralel. Rezultatele se livreaza in ordine prin
+//cate un buffer de reordonare pe flux.
+class StreamExecutor {
+public:
+    explicit StreamExecutor(const ExecutorConfig& config);
+    ~StreamExecutor();
+    StreamExecutor(const StreamExecutor&) = delete;
+    StreamExecutor& operator=(const StreamExecutor&) = delete;
+
+    int addStream(ResultCallback callback);
+    //cadrul e pastrat (Mat cu numarare de referinte) pana la livrare; intoarce indexul lui in flux
+    uint64_t submit(int stream, const Mat& frame);
+    //asteapta livrarea tuturor cadrelor trimise si opreste workerii
+    void shutdown();
+
+    int workerCount() const { return (int)workers.size(); }
+    long long stolenTasks() const { return stolen.load(); }
+    long long stripedFrames() const { return striped.load(); }
+
+private:
+    struct FrameJob {
+        int stream;
+        uint64_t index;
+        Mat frame;
+        vector<Rect> stripes; //benzile proprii (fara suprapunere); gol = tot cadrul
+        int overlap = 0; //cu cat e extinsa fiecare banda in sus si in jos
+        vector<vector<PlateCandidate>> parts;
+        atomic<int> remaining;
+    };
+
+    struct Task {
+        shared_ptr<FrameJob> job;
+        int stripe;
+    };
+
+    struct Stream {
+        ResultCallback callback;
+        mutex deliverMutex;
+        uint64_t nextSubmit = 0;
+        uint64_t nextDeliver = 0;
+        map<uint64_t, vector<PlateCandidate>> ready;
+        atomic<int> inFlight{0};
+        int homeWorker = 0;
+    };
+
+    struct WorkerQueue {
+        mutex queueMutex;
+        deque<Task> tasks;
+    };
+
+    void workerLoop(int workerId);
+    bool popTask(int workerId, Task& task);
+    void push(int workerId, Task&& task);
+    void runTask(LicensePlateDetector& detector, const Task& task);
+    void complete(FrameJob& job);
+    vector<Rect> stripesFor(const Mat& frame, int overlap);
+
+    ExecutorConfig config;
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<thread> workers;
+    mutex streamsMutex;
+    vector<unique_ptr<Stream>> streams;
+
+    mutex idleMutex;
+    condition_variable idleCondition;
+    condition_variable drainedCondition;
+    atomic<long long> queuedTasks{0};
+    atomic<long long> pendingFrames{0};
+    atomic<int> activeStreams{0};
+    atomic<bool> running{true};
+
+    atomic<long long> stolen{0};
+    atomic<long long> striped{0};
+};
+
+#endif
@@ -48,6 +48,7 @@ int main() {
     }
 
     LicensePlateDetector detector;
+    detector.setDebugWindows(false); //doar fereastra cu rezultatul, ca inainte
     float totalIoU = 0.0f;
     int validCount = 0;
 
@@ -65,30 +66,15 @@ int main() {
             continue;
         }
 
-        cv::Mat gray = detector.manualGrayscaleConversion(image);
-        cv::Mat blurred = detector.manualGaussianBlur(gray, 5);
-        cv::Mat edges = detector.manualSobelOperator(blurred);
-        cv::Mat binary = detector.manualThreshold(edges, 0);
-        cv::Mat morphed = detector.manualMorphologicalOperation(binary);
-
-        std::vector<std::vector<cv::Point>> contours;
-        cv::findContours(morphed.clone(), contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-        int maxArea = 0;
-        cv::Rect plateRect;
-        for (const auto& c : contours) {
-            cv::Rect r = cv::boundingRect(c);
-            //forma alungita + pozitionat mai jos in imagine y> 40%
-            if (r.area() > maxArea && r.width > r.height * 2.5 && r.y > morphed.rows * 0.4) {
-                maxArea = r.area();
-                plateRect = r;
-            }
-        }
-
-        if (maxArea == 0) {
+        //ROI: doar partea de jos a imaginii (y > 40%), procesata fara restul cadrului.
+        //pragul Otsu se calculeaza doar pe decupaj, ca in detectLicensePlates cu ROI; scorurile nu
+        //se compara cu cele de dinainte de ROI (atunci pragul venea din tot cadrul)
+        MyRect plate = detector.detectLargestContour(image);
+        if (plate.isEmpty()) {
             std::cout << imageName << " – No plate detected.\n";
             continue;
         }
+        cv::Rect plateRect(plate.x, plate.y, plate.width, plate.height);
 
         std::vector<int> predictedBox = {
             plateRect.x,
@@ -149,6 +135,7 @@ int main() {
         std::cout << "\n==============================" << std::endl;
         std::cout << "Total images processed: " << validCount << std::endl;
         std::cout << "Average IoU: " << averageIoU << std::endl;
+        std::cout << "Tile rejection rate: " << detector.getStats().tileRejectionRate() << std::endl;
         std::cout << "==============================\n" << std::endl;
     } else {
         std::cout << "No valid detections to calculate average IoU.\n";
@@ -0,0 +1,196 @@
+#include "tracer.h"
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Tracer::tracingEnabled{false};
+
+struct TraceEvent {
+    const char* name;
+    uint64_t timestampNs;
+    uint64_t durationNs; //doar pentru 'X'
+    char phase; //'B', 'E' sau 'X'
+};
+
+//~1M evenimente pe thread (~32 MB) cel mult, suficient pentru o captura de 10 secunde;
+//memoria se aloca pe bucati de 16K evenimente (~512 KB), pe masura ce thread-ul le umple
+static const size_t TRACE_CHUNK = 1 << 14;
+static const size_t TRACE_MAX_CHUNKS = 64;
+static const size_t TRACE_CAPACITY = TRACE_CHUNK * TRACE_MAX_CHUNKS;
+
+struct ThreadTrace {
+    std::unique_ptr<TraceEvent[]> chunks[TRACE_MAX_CHUNKS]; //alocate la primul eveniment din bucata
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    uint32_t tid = 0;
+    std::string threadName;
+    bool exited = false; //thread-ul s-a terminat; dupa writeJson intrarea poate fi refolosita
+    bool reusable = false;
+};
+
+//buffer-ele unui thread terminat raman pana la urmatorul writeJson, apoi intrarea e refolosita
+//de un thread nou (acelasi tid), ca serverul sa nu adune cate una pe conexiune
+static std::mutex registryMutex;
+static std::vector<ThreadTrace*> registry;
+static uint64_t recycledDropped = 0;
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+static thread_local std::string pendingThreadName; //numele dat inainte de primul eveniment
+
+//la iesirea thread-ului marcheaza intrarea ca terminata
+struct ThreadTraceOwner {
+    ThreadTrace* trace = nullptr;
+    ~ThreadTraceOwner() {
+        if (trace != nullptr) {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            trace->exited = true;
+        }
+    }
+};
+
+static ThreadTrace& localTrace() {
+    thread_local ThreadTraceOwner owner;
+    if (owner.trace == nullptr) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (ThreadTrace* candidate : registry) {
+            if (candidate->reusable) {
+                owner.trace = candidate;
+                break;
+            }
+        }
+        if (owner.trace == nullptr) {
+            owner.trace = new ThreadTrace();
+            owner.trace->tid = (uint32_t)registry.size() + 1;
+            registry.push_back(owner.trace);
+        }
+        owner.trace->exited = false;
+        owner.trace->reusable = false;
+        owner.trace->threadName = pendingThreadName;
+    }
+    return *owner.trace;
+}
+
+static void record(const char* name, char phase, uint64_t timestampNs, uint64_t durationNs) {
+    ThreadTrace& trace = localTrace();
+    size_t index = trace.count.load(std::memory_order_relaxed);
+    if (index >= TRACE_CAPACITY) {
+        trace.dropped.store(trace.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    std::unique_ptr<TraceEvent[]>& chunk = trace.chunks[index / TRACE_CHUNK];
+    if (!chunk) {
+        //alocat sub mutex: writeJson citeste bucatile doar pentru evenimente sub count
+        std::lock_guard<std::mutex> lock(registryMutex);
+        chunk.reset(new TraceEvent[TRACE_CHUNK]);
+    }
+    chunk[index % TRACE_CHUNK] = {name, timestampNs, durationNs, phase};
+    trace.count.store(index + 1, std::memory_order_release);
+}
+
+uint64_t Tracer::nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+void Tracer::setEnabled(bool enabled) {
+    tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::begin(const char* name) {
+    record(name, 'B', nowNs(), 0);
+}
+
+void Tracer::end(const char* name) {
+    record(name, 'E', nowNs(), 0);
+}
+
+void Tracer::complete(const char* name, uint64_t startNs, uint64_t durationNs) {
+    if (enabled()) {
+        record(name, 'X', startNs, durationNs);
+    }
+}
+
+//fara tracing nu se creeaza nicio intrare; numele e folosit la primul eveniment al thread-ului
+void Tracer::setThreadName(const std::string& name) {
+    pendingThreadName = name;
+    if (!enabled()) {
+        return;
+    }
+    ThreadTrace& trace = localTrace();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    trace.threadName = name;
+}
+
+uint64_t Tracer::droppedEvents() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    uint64_t dropped = recycledDropped;
+    for (const ThreadTrace* trace : registry) {
+        dropped += trace->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+static void writeString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\';
+        }
+        out << *p;
+    }
+    out << '"';
+}
+
+//format Trace Event: timpii in microsecunde
+bool Tracer::writeJson(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out.setf(std::ios::fixed);
+    out.precision(3);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (ThreadTrace* trace : registry) {
+        if (trace->reusable) {
+            continue;
+        }
+        if (!trace->threadName.empty()) {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->tid
+                << ",\"args\":{\"name\":";
+            writeString(out, trace->threadName.c_str());
+            out << "}}";
+            first = false;
+        }
+
+        size_t count = trace->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const TraceEvent& event = trace->chunks[i / TRACE_CHUNK][i % TRACE_CHUNK];
+            out << (first ? "" : ",") << "\n{\"name\":";
+            writeString(out, event.name);
+            out << ",\"ph\":\"" << event.phase << "\",\"ts\":" << event.timestampNs / 1000.0
+                << ",\"pid\":1,\"tid\":" << trace->tid;
+            if (event.phase == 'X') {
+                out << ",\"dur\":" << event.durationNs / 1000.0;
+            }
+            out << "}";
+            first = false;
+        }
+
+        //thread-ul s-a terminat si evenimentele lui au fost scrise: memoria se elibereaza
+        if (trace->exited) {
+            for (std::unique_ptr<TraceEvent[]>& chunk : trace->chunks) {
+                chunk.reset();
+            }
+            recycledDropped += trace->dropped.load(std::memory_order_relaxed);
+            trace->count.store(0, std::memory_order_relaxed);
+            trace->dropped.store(0, std::memory_order_relaxed);
+            trace->threadName.clear();
+            trace->reusable = true;
+        }
+    }
+    out << "\n]}\n";
+    return out.good();
+}
@@ -0,0 +1,50 @@
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+//tracer optional pentru Chrome / Perfetto (chrome://tracing, ui.perfetto.dev).
+//fiecare thread scrie span-uri intr-un buffer propriu, alocat pe bucati (un singur
+//scriitor, publicat cu release); writeJson le citeste pe toate fara sa opreasca thread-urile.
+//numele trebuie sa fie siruri statice: se pastreaza doar pointerul.
+
+class Tracer {
+public:
+    static void setEnabled(bool enabled);
+    static bool enabled() { return tracingEnabled.load(std::memory_order_relaxed); }
+
+    static void begin(const char* name);
+    static void end(const char* name);
+    //span masurat de altcineva (de ex. asteptarea in coada, intre doua thread-uri)
+    static void complete(const char* name, uint64_t startNs, uint64_t durationNs);
+    static void setThreadName(const std::string& name);
+
+    static uint64_t nowNs();
+    static bool writeJson(const std::string& path);
+    static uint64_t droppedEvents();
+
+private:
+    static std::atomic<bool> tracingEnabled;
+};
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* _name) : name(_name), active(Tracer::enabled()) {
+        if (active) {
+            Tracer::begin(name);
+        }
+    }
+    ~TraceSpan() {
+        if (active) {
+            Tracer::end(name);
+        }
+    }
+
+private:
+    const char* name;
+    bool active;
+};
+
+#endif
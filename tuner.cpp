@@ -0,0 +1,265 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "proj.h"
+#include "stage_cache.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+//cauta in paralel prin spatiul de parametri pe un set etichetat (format annotations.json)
+//si raporteaza frontul Pareto: IoU mediu maxim pentru fiecare cost in ms/cadru.
+//cu toate nucleele ocupate timpii sunt contaminati de concurenta (cache, frecventa), asa ca
+//primele straturi Pareto sunt re-cronometrate pe un singur thread inainte de frontul final
+
+struct Sample {
+    std::string name;
+    cv::Mat image;
+    MyRect groundTruth;
+};
+
+struct Evaluation {
+    DetectorParams params;
+    double meanIoU = 0.0;
+    double msPerFrame = 0.0;
+    int detected = 0;
+    size_t index = 0; //pozitia in lista de candidati
+};
+
+static std::vector<Sample> loadSamples(const fs::path& annotationsPath, const fs::path& imageDir) {
+    std::vector<Sample> samples;
+    std::ifstream inFile(annotationsPath);
+    if (!inFile.is_open()) {
+        std::cerr << "Error: Could not open annotations file " << annotationsPath << std::endl;
+        return samples;
+    }
+    json annotations;
+    inFile >> annotations;
+
+    for (auto it = annotations.begin(); it != annotations.end(); ++it) {
+        if (!it.value().is_array() || it.value().size() != 4) {
+            continue; //de ex. cheia "pozitionare" care descrie formatul
+        }
+        cv::Mat image = cv::imread((imageDir / it.key()).string());
+        if (image.empty()) {
+            std::cerr << "Skipping " << it.key() << ": image not found or unreadable.\n";
+            continue;
+        }
+        std::vector<int> box = it.value();
+        samples.push_back({it.key(), image, MyRect(box[0], box[1], box[2] - box[0], box[3] - box[1])});
+    }
+    return samples;
+}
+
+//spatiul de cautare: valori discrete in jurul celor implicite, doar parametrii de care depinde
+//selectia din test.cpp (detectLargestContour); filtrele de arie/aspect ale candidatelor nu intra acolo
+static DetectorParams randomParams(std::mt19937& rng) {
+    auto pick = [&](const auto& values) { return values[rng() % values.size()]; };
+    const std::vector<int> blurSizes = {3, 5, 7};
+    const std::vector<int> morphWidths = {9, 13, 17, 21};
+    const std::vector<int> morphHeights = {1, 3, 5};
+    const std::vector<double> selectionAspects = {1.5, 2.0, 2.5, 3.0, 3.5};
+    const std::vector<double> roiTops = {0.0, 0.3, 0.4, 0.5};
+    const std::vector<bool> cascades = {false, true};
+
+    DetectorParams params;
+    params.blurKernelSize = pick(blurSizes);
+    params.morphWidth = pick(morphWidths);
+    params.morphHeight = pick(morphHeights);
+    params.selectionAspectMin = pick(selectionAspects);
+    params.roiTopFraction = pick(roiTops);
+    params.useTileCascade = pick(cascades);
+    return params;
+}
+
+static json paramsToJson(const DetectorParams& params) {
+    return {
+        {"blurKernelSize", params.blurKernelSize},
+        {"morphWidth", params.morphWidth},
+        {"morphHeight", params.morphHeight},
+        {"selectionAspectMin", params.selectionAspectMin},
+        {"roiTopFraction", params.roiTopFraction},
+        {"useTileCascade", params.useTileCascade}
+    };
+}
+
+static Evaluation evaluate(const DetectorParams& params, const std::vector<Sample>& samples, int repeat, StageCache* cache) {
+    LicensePlateDetector detector(params);
+    detector.setDebugWindows(false);
+    detector.setStageCache(cache);
+
+    Evaluation result;
+    result.params = params;
+    double totalIoU = 0.0;
+    double totalMs = 0.0;
+    for (const Sample& sample : samples) {
+        //aceeasi selectie ca test.cpp, deci IoU-ul e comparabil cu cel raportat acolo
+        MyRect plate;
+        Clock::time_point start = Clock::now();
+        for (int r = 0; r < repeat; r++) {
+            plate = detector.detectLargestContour(sample.image);
+        }
+        totalMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeat;
+
+        //ratarea conteaza ca IoU 0, altfel o configuratie care nu gaseste nimic ar parea perfecta
+        if (!plate.isEmpty()) {
+            totalIoU += plate.iou(sample.groundTruth);
+            result.detected++;
+        }
+    }
+    result.meanIoU = totalIoU / samples.size();
+    result.msPerFrame = totalMs / samples.size();
+    return result;
+}
+
+//frontul Pareto: dupa cost crescator, pastram doar ce imbunatateste IoU
+static std::vector<Evaluation> paretoFront(std::vector<Evaluation> evaluations) {
+    std::sort(evaluations.begin(), evaluations.end(), [](const Evaluation& a, const Evaluation& b) {
+        return a.msPerFrame != b.msPerFrame ? a.msPerFrame < b.msPerFrame : a.meanIoU > b.meanIoU;
+    });
+    std::vector<Evaluation> front;
+    double bestIoU = -1.0;
+    for (const Evaluation& evaluation : evaluations) {
+        if (evaluation.meanIoU > bestIoU) {
+            front.push_back(evaluation);
+            bestIoU = evaluation.meanIoU;
+        }
+    }
+    return front;
+}
+
+int main(int argc, char** argv) {
+    cv::utils::logging::setLogLevel(cv::utils::logging::LOG_LEVEL_SILENT);
+
+    fs::path annotationsPath = fs::current_path().parent_path() / "annotations.json";
+    fs::path imageDir = fs::current_path().parent_path() / "Tests";
+    std::string outputPath = "pareto_front.json";
+    int configurations = 200;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    int repeat = 1;
+    int finalistLayers = 2; //straturi Pareto re-cronometrate serial
+    double minIoU = 0.5;
+    unsigned seed = 42;
+    size_t cacheMb = 0; //0 = fara cache; atunci ms/cadru e costul complet al pipeline-ului
+    std::string cacheDir;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--annotations") annotationsPath = value;
+        else if (key == "--images") imageDir = value;
+        else if (key == "--output") outputPath = value;
+        else if (key == "--configs") configurations = std::stoi(value);
+        else if (key == "--threads") threads = std::max(1, std::stoi(value));
+        else if (key == "--repeat") repeat = std::max(1, std::stoi(value));
+        else if (key == "--finalist-layers") finalistLayers = std::max(1, std::stoi(value));
+        else if (key == "--min-iou") minIoU = std::stod(value);
+        else if (key == "--seed") seed = (unsigned)std::stoul(value);
+        else if (key == "--cache-mb") cacheMb = std::stoul(value);
+        else if (key == "--cache-dir") cacheDir = value;
+        else std::cerr << "Unknown option " << key << std::endl;
+    }
+
+    std::vector<Sample> samples = loadSamples(annotationsPath, imageDir);
+    if (samples.empty()) {
+        std::cerr << "No labeled images to tune on." << std::endl;
+        return -1;
+    }
+
+    //configuratia implicita e mereu evaluata, ca referinta
+    std::mt19937 rng(seed);
+    std::vector<DetectorParams> candidates = {DetectorParams()};
+    while ((int)candidates.size() < configurations) {
+        candidates.push_back(randomParams(rng));
+    }
+
+    //cu cache, ms/cadru masoara doar etapele recalculate: util pentru IoU, nu pentru cost
+    std::unique_ptr<StageCache> cache;
+    if (cacheMb > 0 || !cacheDir.empty()) {
+        cache = std::make_unique<StageCache>((cacheMb > 0 ? cacheMb : 512) << 20, cacheDir);
+    }
+
+    std::vector<Evaluation> evaluations(candidates.size());
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> finished{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            for (size_t i = next++; i < candidates.size(); i = next++) {
+                evaluations[i] = evaluate(candidates[i], samples, repeat, cache.get());
+                evaluations[i].index = i;
+                size_t done = ++finished;
+                if (done % 20 == 0) {
+                    std::cout << "Evaluated " << done << "/" << candidates.size() << std::endl;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    //finalistii: primele straturi Pareto dupa timpii paraleli (un strat nou dupa ce il scoatem pe
+    //cel precedent), plus configuratia implicita; re-cronometrati serial, fara cache, ca ms/cadru
+    //sa fie costul complet necontestat
+    std::vector<bool> finalist(evaluations.size(), false);
+    finalist[0] = true;
+    std::vector<Evaluation> remaining = evaluations;
+    for (int layer = 0; layer < finalistLayers && !remaining.empty(); layer++) {
+        for (const Evaluation& evaluation : paretoFront(remaining)) {
+            finalist[evaluation.index] = true;
+        }
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [&](const Evaluation& e) { return finalist[e.index]; }),
+                        remaining.end());
+    }
+    std::vector<Evaluation> finalists;
+    for (size_t i = 0; i < evaluations.size(); i++) {
+        if (finalist[i]) {
+            evaluations[i] = evaluate(candidates[i], samples, repeat, nullptr);
+            evaluations[i].index = i;
+            finalists.push_back(evaluations[i]);
+        }
+    }
+    std::cout << "Re-timed " << finalists.size() << " finalists on one thread" << std::endl;
+
+    const Evaluation& baseline = evaluations[0];
+    std::vector<Evaluation> front = paretoFront(finalists);
+
+    std::cout << "\n=== Pareto front (" << samples.size() << " images, " << candidates.size() << " configs) ===" << std::endl;
+    std::cout << "Default: IoU " << baseline.meanIoU << ", " << baseline.msPerFrame << " ms/frame" << std::endl;
+    json output = json::array();
+    for (const Evaluation& evaluation : front) {
+        std::cout << "IoU " << evaluation.meanIoU << "  " << evaluation.msPerFrame << " ms/frame  detected "
+                  << evaluation.detected << "/" << samples.size() << "  " << paramsToJson(evaluation.params).dump() << std::endl;
+        json entry = paramsToJson(evaluation.params);
+        entry["meanIoU"] = evaluation.meanIoU;
+        entry["msPerFrame"] = evaluation.msPerFrame;
+        output.push_back(entry);
+    }
+
+    //cea mai ieftina configuratie acceptabila pentru camera
+    for (const Evaluation& evaluation : front) {
+        if (evaluation.meanIoU >= minIoU) {
+            std::cout << "\nCheapest config with IoU >= " << minIoU << ": " << evaluation.msPerFrame << " ms/frame, "
+                      << paramsToJson(evaluation.params).dump() << std::endl;
+            break;
+        }
+    }
+
+    if (cache) {
+        cache->printStats(std::cout);
+    }
+
+    std::ofstream outFile(outputPath);
+    outFile << output.dump(2) << std::endl;
+    return 0;
+}